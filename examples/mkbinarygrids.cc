@@ -0,0 +1,28 @@
+// Example program to convert the members of PDF sets to the memory-mappable binary grid format
+
+#include "LHAPDF/LHAPDF.h"
+#include "LHAPDF/BinaryGrid.h"
+#include <iostream>
+using namespace std;
+
+int main(int argc, char* argv[]) {
+
+  if (argc < 2) {
+    cerr << "Usage: " << argv[0] << " <setname> [<setname> ...]" << endl;
+    return 1;
+  }
+
+  LHAPDF::setVerbosity(0);
+  for (int iarg = 1; iarg < argc; ++iarg) {
+    const string setname = argv[iarg];
+    const LHAPDF::PDFSet set(setname);
+    for (size_t imem = 0; imem < set.size(); ++imem) {
+      // Always convert the ASCII file, even if a binary version is already present
+      const string datpath = LHAPDF::findFile(LHAPDF::pdfmempath(setname, imem));
+      LHAPDF::convertToBinaryGrid(datpath);
+      cout << "Wrote " << LHAPDF::binaryGridPath(datpath) << endl;
+    }
+  }
+
+  return 0;
+}
@@ -40,6 +40,13 @@ namespace LHAPDF {
     /// @todo Throw error in this base method if Q < Lambda?
     virtual double alphasQ2(double q2) const = 0;
 
+    /// @brief Compute any lazily-tabulated state now, rather than on the first alphasQ2 call
+    ///
+    /// After this, the const methods of the object make no writes, so it can be
+    /// queried from any number of threads without locking. Calling a setter
+    /// undoes the freezing, and must not race with queries.
+    virtual void freeze() { }
+
     ///@}
 
 
@@ -222,6 +229,9 @@ namespace LHAPDF {
     /// Calculate alphaS(Q2)
     double alphasQ2(double q2) const;
 
+    /// Build the interpolation subgrids now
+    void freeze();
+
     /// Set the array of Q values for interpolation
     ///
     /// Writes to the same internal arrays as setQ2Values, appropriately transformed.
@@ -232,14 +242,14 @@ namespace LHAPDF {
     /// Subgrids are represented by repeating the values which are the end of
     /// one subgrid and the start of the next. The supplied vector must match
     /// the layout of alpha_s values.
-    void setQ2Values(const std::vector<double>& q2s) { _q2s = q2s; }
+    void setQ2Values(const std::vector<double>& q2s) { _q2s = q2s; _knotarrays.clear(); }
 
     /// Set the array of alpha_s(Q2) values for interpolation
     ///
     /// The supplied vector must match the layout of Q2 knots.  Subgrids may
     /// have discontinuities, i.e. different alpha_s values on either side of a
     /// subgrid boundary (for the same Q values).
-    void setAlphaSValues(const std::vector<double>& as) { _as = as; }
+    void setAlphaSValues(const std::vector<double>& as) { _as = as; _knotarrays.clear(); }
 
 
   private:
@@ -281,6 +291,9 @@ namespace LHAPDF {
     /// Calculate alphaS(Q2)
     double alphasQ2( double q2 ) const;
 
+    /// Solve the ODE and build its interpolation grid now
+    void freeze() { _interpolate(); _ipol.freeze(); }
+
     /// Set MZ, and also the caching flag
     void setMZ( double mz ) { _mz = mz; _calculated = false; }
 
@@ -325,7 +338,7 @@ namespace LHAPDF {
     mutable std::vector<double> _q2s;
 
     /// Whether or not the ODE has been solved yet
-    mutable bool _calculated;
+    mutable bool _calculated = false;
 
     /// The interpolation used to get Alpha_s after the ODE has been solved
     mutable AlphaS_Ipol _ipol;
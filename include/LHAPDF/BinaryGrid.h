@@ -0,0 +1,195 @@
+// -*- C++ -*-
+//
+// This file is part of LHAPDF
+// Copyright (C) 2012-2019 The LHAPDF collaboration (see AUTHORS for details)
+//
+#pragma once
+#ifndef LHAPDF_BinaryGrid_H
+#define LHAPDF_BinaryGrid_H
+
+#include "LHAPDF/Utils.h"
+#include "LHAPDF/KnotArray.h"
+#include "LHAPDF/FileIO.h"
+#include <cstdint>
+#include <functional>
+
+namespace LHAPDF {
+
+
+  // Forward declaration
+  class GridPDF;
+
+
+  /// @defgroup binarygrid Binary, memory-mappable grid data files
+  ///
+  /// A PDF member may be stored as a binary .bdat file alongside (or instead
+  /// of) its ASCII .dat file. The binary file contains the same YAML metadata
+  /// header text, followed by the subgrids with their knots, flavor tables and
+  /// xf values in native double precision. The xf blocks are aligned so that
+  /// a GridPDF can mmap the file and view the data in place, with no parsing
+  /// or copying: processes on the same node then share the page cache.
+  ///
+  /// The layout, with all integers as native uint64 values, is
+  ///  - header: magic "LHAPDFbg", format version, byte-order mark, metadata length, number of subgrids, 3 reserved words
+  ///    (zero, except in grid cache entries, which store their source key and a checksum of the rest of the file);
+  ///  - metadata: the YAML header text, zero-padded to a multiple of 8 bytes;
+  ///  - per subgrid: nx, nQ2, nflavors, a reserved word, the x and Q2 knots, the
+  ///    PIDs (as int64), zero-padding to a 64-byte boundary, and the xf values as [flavor][ix][iQ2].
+  ///
+  /// Files with a different byte-order mark are rejected rather than byte-swapped.
+  ///@{
+
+  /// Current version of the binary grid format
+  const uint64_t BINARYGRID_VERSION = 1;
+
+  /// File extension of binary grid files
+  const std::string BINARYGRID_EXTN = "bdat";
+
+
+  /// Is the file at @a path (judged by its extension) a binary grid file?
+  inline bool isBinaryGridPath(const std::string& path) {
+    return file_extn(path) == BINARYGRID_EXTN;
+  }
+
+  /// Get the binary grid file path corresponding to the ASCII member file @a datpath, which may be compressed
+  inline std::string binaryGridPath(const std::string& datpath) {
+    const std::string path = uncompressedPath(datpath);
+    return ((file_extn(path) == "dat") ? file_stem(path) : path) + "." + BINARYGRID_EXTN;
+  }
+
+
+  /// @brief Read-only memory mapping of a whole file
+  ///
+  /// The mapping is released when the last copy of the returned handle is destroyed.
+  std::shared_ptr<const char> mapFile(const std::string& path, size_t& size);
+
+  /// Read the YAML metadata header text from a binary grid file
+  std::string readBinaryGridMetadata(const std::string& path);
+
+  /// @brief Memory-map the binary grid file at @a path, and register its subgrids in @a arrays
+  ///
+  /// The xf values are not copied: the KnotArray1F objects view the mapped
+  /// file, which stays mapped for as long as any of them exists. If @a metadata
+  /// is non-null, the YAML header text is also copied into it from the mapping.
+  void readBinaryGrid(const std::string& path, std::map<double, KnotArrayNF>& arrays, std::string* metadata=nullptr);
+
+  /// @brief Register the subgrids of the in-memory binary grid image @a data in @a arrays
+  ///
+  /// As for readBinaryGrid, but from an image of @a size bytes which is viewed
+  /// rather than copied. The @a name is used in error messages.
+  void readGridImage(const std::shared_ptr<const char>& data, size_t size, const std::string& name,
+                     std::map<double, KnotArrayNF>& arrays, std::string* metadata=nullptr);
+
+
+  /// @brief Assemble the binary grid file contents for the given subgrids, flavors and metadata text
+  ///
+  /// Flavors in @a flavors which are missing from a subgrid are skipped.
+  std::string binaryGridImage(const std::map<double, KnotArrayNF>& arrays, const std::vector<int>& flavors, const std::string& metadata);
+
+  /// @brief Write the grids of @a pdf and the given metadata text to a binary grid file
+  ///
+  /// The file is written under a temporary name and then renamed into place,
+  /// so concurrent readers never see a partially written file.
+  void writeBinaryGrid(const GridPDF& pdf, const std::string& metadata, const std::string& path);
+
+  /// @brief Convert an ASCII .dat member file to a binary grid file
+  ///
+  /// If @a binpath is empty, the .bdat file is written next to the .dat file.
+  void convertToBinaryGrid(const std::string& datpath, const std::string& binpath="");
+
+  ///@}
+
+
+  /// @defgroup sharedgrid Node-local shared-memory grid store
+  ///
+  /// Many independent processes on one node can share a single parsed copy of
+  /// each ASCII member file, held as a binary grid image in a named POSIX
+  /// shared-memory segment. The first process to load a member parses it and
+  /// publishes the image, and later processes attach to it read-only, with
+  /// no parsing. Creation is serialised by a lock file in the temporary
+  /// directory, so each member is only parsed once per node.
+  ///
+  /// Segments are named from the member file's path, size and modification
+  /// time, so an updated file is published afresh, and the segment for its
+  /// previous version is then removed. There is one lock file per member path,
+  /// recording its current segment. Segments persist after the processes exit,
+  /// for reuse by later jobs, until superseded, removed with removeSharedGrid,
+  /// or a reboot.
+  ///@{
+
+  /// Get the shared-memory segment name for the member file at @a mempath
+  std::string sharedGridName(const std::string& mempath);
+
+  /// @brief Attach to the shared grid image for @a mempath, registering its subgrids in @a arrays
+  ///
+  /// If the segment does not exist yet, it is first created from the image
+  /// returned by @a mkimage, which is only called by the one process which
+  /// publishes it. As for readBinaryGrid, the xf values view the mapped image,
+  /// and the metadata text is copied into @a metadata if it is non-null.
+  void readSharedGrid(const std::string& mempath, std::map<double, KnotArrayNF>& arrays, std::string* metadata,
+                      const std::function<std::string()>& mkimage);
+
+  /// @brief Remove the shared grid image for @a mempath, if it exists
+  ///
+  /// Processes which are attached to the image can continue to use it.
+  bool removeSharedGrid(const std::string& mempath);
+
+  ///@}
+
+
+  /// @defgroup gridimages Preloaded grid images
+  ///
+  /// Binary grid images can be registered in advance for member file paths,
+  /// e.g. after receiving them by MPI broadcast. GridPDF then loads a
+  /// registered member from its image, without accessing the file, and the
+  /// registration is dropped.
+  ///@{
+
+  /// Register the binary grid image @a data, of @a size bytes, for the member file at @a mempath
+  void registerGridImage(const std::string& mempath, const std::shared_ptr<const char>& data, size_t size);
+
+  /// Remove and return the image registered for @a mempath, setting its @a size, or return null if there is none
+  std::shared_ptr<const char> takeGridImage(const std::string& mempath, size_t& size);
+
+  /// Drop all registered images
+  void clearGridImages();
+
+  ///@}
+
+
+  /// @defgroup gridcache Persistent on-disk cache of parsed grids
+  ///
+  /// When a cache directory is set, by the LHAPDF_GRID_CACHE environment
+  /// variable or else the GridCacheDir config option, each ASCII member file is
+  /// only parsed on its first load. Its grids are then saved to the cache as a
+  /// binary grid file, which later loads memory-map instead of parsing. Each
+  /// entry records a key hashed from the source file's path, size and
+  /// modification time, which is all that a load normally checks, plus
+  /// checksums of the source contents and of the entry itself. These are only
+  /// recomputed if the key does not match, e.g. for a source with a new mtime
+  /// but the same contents, which keeps its entry, or for every load if the
+  /// GridCacheVerify config option is true. Stale or corrupt entries are
+  /// rebuilt automatically. The knot logarithms are recomputed from the cached
+  /// knots, which is negligible work.
+  ///@{
+
+  /// Get the grid cache directory, or an empty string if caching is disabled
+  std::string gridCacheDir();
+
+  /// Get the grid cache file path for the member file at @a mempath, or an empty string if caching is disabled
+  std::string gridCachePath(const std::string& mempath);
+
+  /// @brief Read the cached grids for @a mempath into @a arrays, rebuilding the cache entry if necessary
+  ///
+  /// If there is no valid entry, @a mkimage is called to parse the member and
+  /// return its binary grid image, which is written to the cache. Failure to
+  /// write the entry is only a warning. The metadata text is copied into
+  /// @a metadata if it is non-null.
+  void readCachedGrid(const std::string& mempath, std::map<double, KnotArrayNF>& arrays, std::string* metadata,
+                      const std::function<std::string()>& mkimage);
+
+  ///@}
+
+
+}
+#endif
@@ -10,20 +10,72 @@
 // STL includes
 #include <fstream>
 #include <sstream>
+#include <streambuf>
 #include <string>
+#include <vector>
+#include <memory>
 
 /// Namespace for all LHAPDF functions and classes
 namespace LHAPDF {
 
 
+  /// @brief Read-only input stream buffer over shared, in-memory file content
+  ///
+  /// Parsers which recognise this buffer can scan the unread content in place
+  /// rather than copying it out through the stream.
+  class SharedContentBuf : public std::streambuf {
+  public:
+
+    /// Constructor from the file content, which must not be null
+    SharedContentBuf(const std::shared_ptr<const std::string>& content);
+
+    /// The whole content
+    const std::string& content() const { return *_content; }
+
+    /// @brief Start of the unread content
+    ///
+    /// The unread range is followed by a NUL, and stays valid as long as this buffer exists.
+    const char* unreadBegin() const { return gptr(); }
+
+    /// End of the unread content
+    const char* unreadEnd() const { return egptr(); }
+
+
+  protected:
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which);
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+
+
+  private:
+
+    std::shared_ptr<const std::string> _content;
+
+  };
+
+
+
   /// @brief MPI-safe file I/O interface
+  ///
+  /// Input files are read whole into memory and then streamed from a
+  /// SharedContentBuf. With MPI, rank 0 broadcasts the content to the other
+  /// ranks and all ranks keep it in a shared file cache (see setFileCacheSize).
+  /// Whole PDF sets are better distributed in one go, by PDFSet::mkPDFs.
+  /// Input files compressed with a codec supported by this build (see
+  /// isCompressedPath) are decompressed incrementally as the stream is read:
+  /// only the compressed bytes are held in memory.
   template <class FILETYPE>
   class File {
   public:
 
-    // Constructor
-    File(const std::string& name)
-      : _name(name), _fileptr(nullptr), _streamptr(nullptr) {
+    /// @brief Constructor
+    ///
+    /// With MPI, opening and closing are collective operations on all ranks,
+    /// unless @a collective is false: then the file is read or written by this
+    /// rank alone, bypassing the broadcast and the file cache.
+    File(const std::string& name, bool collective=true)
+      : _name(name), _collective(collective), _fileptr(nullptr), _streamptr(nullptr), _contentptr(nullptr), _bufptr(nullptr) {
       open();
     }
 
@@ -44,17 +96,29 @@ namespace LHAPDF {
     FILETYPE& operator*() const { return *_fileptr; }
 
     /// Get the file content
-    std::string getContent() const { return _streamptr != nullptr ? _streamptr->str() : ""; }
+    std::string getContent() const {
+      if (_contentptr != nullptr) return _contentptr->content();
+      return _streamptr != nullptr ? _streamptr->str() : "";
+    }
 
 
   protected:
 
     std::string _name;
 
+    bool _collective;
+
     FILETYPE* _fileptr;
 
+    /// Output buffer, written to the file on closing
     std::stringstream* _streamptr;
 
+    /// Input buffer over the file content
+    SharedContentBuf* _contentptr;
+
+    /// Decompressing buffer reading from _contentptr, for compressed input files
+    std::streambuf* _bufptr;
+
   };
 
 
@@ -68,6 +132,40 @@ namespace LHAPDF {
   /// Global function to flush the MPI-safe file cache
   void flushFileCache();
 
+  /// @brief Set the byte budget of the MPI-safe file cache
+  ///
+  /// The budget is unlimited by default. If one is set, the earliest cached file
+  /// contents are evicted to stay within it, and files bigger than it are not
+  /// cached. Evicted contents stay alive for as long as a reader holds them.
+  /// Since cache hits decide which MPI ranks take part in a broadcast, this must
+  /// be called with the same budget on all ranks, between the same collective
+  /// file reads.
+  void setFileCacheSize(size_t bytes);
+
+
+  /// @name Compressed data files
+  ///@{
+
+  /// Does @a path have a compressed-file extension, .gz (zlib) or .zst (zstd)?
+  inline bool isCompressedPath(const std::string& path) {
+    const size_t idot = path.rfind('.');
+    if (idot == std::string::npos) return false;
+    const std::string extn = path.substr(idot+1);
+    return extn == "gz" || extn == "zst";
+  }
+
+  /// The path of the uncompressed equivalent of @a path, i.e. without any compression extension
+  inline std::string uncompressedPath(const std::string& path) {
+    return isCompressedPath(path) ? path.substr(0, path.rfind('.')) : path;
+  }
+
+  /// @brief Compressed-file extensions which can be read by this build, fastest codec first
+  ///
+  /// Empty if LHAPDF was built without zlib and zstd.
+  const std::vector<std::string>& compressedExtns();
+
+  ///@}
+
 
 }
 #endif
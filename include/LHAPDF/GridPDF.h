@@ -11,6 +11,8 @@
 #include "LHAPDF/Interpolator.h"
 #include "LHAPDF/Extrapolator.h"
 #include "LHAPDF/KnotArray.h"
+#include <atomic>
+#include <mutex>
 
 namespace LHAPDF {
 
@@ -34,25 +36,19 @@ namespace LHAPDF {
     /// probably (hopefully) know what you're doing and aren't putting it into
     /// public production code!
     GridPDF(const std::string& path) {
-      _loadInfo(path); // Sets _mempath
-      _loadPlugins();
-      _loadData(_mempath);
+      _loadMember(path); // Sets _mempath
       _forcePos = -1;
     }
 
     /// Constructor from a set name and member ID
     GridPDF(const std::string& setname, int member) {
-      _loadInfo(setname, member); // Sets _mempath
-      _loadPlugins();
-      _loadData(_mempath);
+      _loadMember(_findmempath(setname, member)); // Sets _mempath
       _forcePos = -1;
     }
 
     /// Constructor from an LHAPDF ID
     GridPDF(int lhaid) {
-      _loadInfo(lhaid); // Sets _mempath
-      _loadPlugins();
-      _loadData(_mempath);
+      _loadMember(_findmempath(lhaid)); // Sets _mempath
       _forcePos = -1;
     }
 
@@ -60,6 +56,15 @@ namespace LHAPDF {
     virtual ~GridPDF() { }
 
 
+    /// @brief Parse the ASCII member file at @a mempath, and return its binary grid image
+    ///
+    /// The file is read by this process alone, even in an MPI build.
+    static std::string gridImage(const std::string& mempath) {
+      GridPDF pdf;
+      return pdf._mkGridImage(mempath);
+    }
+
+
   protected:
 
     /// Load the interpolator, based on current metadata
@@ -75,9 +80,62 @@ namespace LHAPDF {
       _loadExtrapolator();
     }
 
+    /// @brief Load the metadata, plugins, and grid data from the given PDF member file
+    ///
+    /// The file is read in a single pass, with the metadata header and the
+    /// data blocks handed on to their respective parsers. If the LazyLoad
+    /// config option is set, only the metadata header is read here and the
+    /// grid data loading is deferred until it is first needed. A grid image
+    /// registered for @a mempath is used instead of the file, and always
+    /// loaded at once since it is already in memory.
+    void _loadMember(const std::string& mempath);
+
+    /// Ensure that the grid data has been loaded, if its loading was deferred
+    void _ensureData() const {
+      if (!_dataloaded.load(std::memory_order_acquire)) _loadDeferredData();
+    }
+
+    /// Load deferred grid data: thread-safe, and only done once
+    void _loadDeferredData() const;
+
+    /// @brief Parse the ASCII member file @a mempath, and return its binary grid image
+    ///
+    /// Used to publish the member to the node-local shared-memory grid store,
+    /// when the SharedMemoryGrids config option is set, or to the on-disk
+    /// grid cache, when a cache directory is set. The file is read by this
+    /// process alone, since only one process of an MPI job may be doing so.
+    std::string _mkGridImage(const std::string& mempath);
+
     /// Load the PDF grid data block (not the metadata) from the given PDF member file
+    ///
+    /// Binary .bdat files are memory-mapped, and ASCII .dat files parsed.
     void _loadData(const std::string& mempath);
 
+    /// @brief Parse the PDF grid data blocks from an ASCII PDF member stream, positioned after the metadata header
+    ///
+    /// The @a nheaderlines already read are counted in the file line numbers of error
+    /// messages, and each block must declare @a nflavors flavors.
+    void _loadAsciiData(std::istream& stream, const std::string& mempath, int nheaderlines, size_t nflavors);
+
+    /// Rebuild the subgrid lookup tables and the Q2 knot list from the knot arrays, if they are out of date
+    void _indexSubgrids() const;
+
+    /// Whether the subgrid lookup tables are built, and still match the subgrid map's size and end keys
+    bool _subgridIndexCurrent() const;
+
+    /// Check that the metadata declares a data format which can be loaded as a GridPDF
+    void _checkFormat(const std::string& mempath) const;
+
+    /// @brief Check the flavor content of the loaded grids, and apply any storage-layout options
+    ///
+    /// Flavors declared in the FlavorAliases metadata, or found to have
+    /// bit-identical grids when the (opt-in) AliasFlavors option is set, share
+    /// a single stored grid. A ReadError is thrown if a declared alias's grid
+    /// differs from its target's. The XfPrecision option selects the storage precision of the
+    /// xf values (see KnotArray1F::Precision): a MetadataError is thrown if a
+    /// reduced precision is combined with InterleaveFlavors.
+    void _finishData(const std::string& mempath);
+
 
   public:
 
@@ -148,22 +206,91 @@ namespace LHAPDF {
     ///@}
 
 
+    /// @brief Load the grid data now, if its loading has been deferred
+    ///
+    /// With the LazyLoad config option, the grid data file is only parsed on
+    /// first use. Calling this explicitly moves that cost (and any read errors)
+    /// to a predictable point, e.g. before entering a timed or multi-threaded region.
+    ///
+    /// With MPI, the metadata header is read collectively at construction, but
+    /// the deferred grid data read is made by each rank on its own, so ranks may
+    /// load or query different members without deadlocking. Each rank then reads
+    /// the file itself, rather than receiving it from rank 0.
+    void preload() const override { _ensureData(); }
+
+    /// @brief Compute all lazily-derived state now, for lock-free concurrent queries
+    ///
+    /// In addition to the generic PDF::freeze work, this fills the Q2 knot
+    /// list, the subgrid lookup tables and any interpolator tables.
+    void freeze() override;
+
+
   protected:
 
     /// @brief Get PDF xf(x,Q2) value (via grid inter/extrapolators)
     double _xfxQ2(int id, double x, double q2) const;
 
+    /// @brief Get PDF xf(x,Q2) values at a batch of points
+    ///
+    /// The in-range points are interpolated in bulk, and any out-of-range
+    /// ones then extrapolated point-by-point in a second pass.
+    void _xfxQ2(int id, const double* xs, const double* q2s, double* out, size_t n) const;
+
+    /// @brief Get PDF xf(x,Q2) values for several PIDs
+    ///
+    /// In-range points are interpolated for all flavors at once, sharing the
+    /// subgrid lookup, knot indices and interpolation weights.
+    void _xfxQ2(double x, double q2, const int* ids, double* out, size_t nids) const;
+
+    /// @brief Get PDF xf(x,Q2) values for all combinations of several PIDs, x and Q2 values
+    ///
+    /// With a separable interpolator, the knot weights of each x and Q2 node
+    /// are computed once, and for each flavor and in-range Q2 node the needed
+    /// Q2 knot rows are interpolated once, then swept over the in-range x
+    /// nodes. Other nodes are extrapolated point-by-point.
+    void _tabulate(const std::vector<double>& xs, const std::vector<double>& q2s,
+                   const int* ids, size_t nids, double* out) const;
+
 
   public:
 
     /// @name Info about the grid, and access to the raw data points
     ///@{
 
-    /// Directly access the knot arrays in non-const mode, for programmatic filling
+    /// @brief Directly access the knot arrays in non-const mode, for programmatic filling
+    ///
+    /// Throws a LogicError if this PDF has been frozen.
+    ///
+    /// @note The subgrid lookup tables are rebuilt after this call, and after
+    /// any change through the returned reference to the number of subgrids or
+    /// to the lowest or highest subgrid edge. If inner subgrids are inserted or
+    /// erased without changing those, the reference must be fetched again by
+    /// calling this function before the next query.
+    /// Changes to the xf values of a flavor grid are always picked up, as long
+    /// as KnotArray1F::xfs is called for each change (see KnotArray1F::version).
     std::map<double, KnotArrayNF>& knotarrays() {
+      if (frozen()) throw LogicError("Can't modify the grids of a frozen PDF");
+      _ensureData();
+      _subgridsindexed.store(false, std::memory_order_release); //< the subgrids may be changed
+      return _knotarrays;
+    }
+
+    /// Directly access the knot arrays in const mode
+    const std::map<double, KnotArrayNF>& knotarrays() const {
+      _ensureData();
       return _knotarrays;
     }
 
+    /// @brief Generation number of the grids, changed whenever they may have been modified or reloaded
+    ///
+    /// Interpolators with tables derived from the grid values use this to tell
+    /// when to rebuild them.
+    size_t gridGeneration() const {
+      _ensureData();
+      if (!_subgridIndexCurrent()) _indexSubgrids();
+      return _gridgeneration.load(std::memory_order_acquire);
+    }
+
     /// Get the N-flavour subgrid containing Q2 = q2
     const KnotArrayNF& subgrid(double q2) const;
 
@@ -176,6 +303,7 @@ namespace LHAPDF {
     ///
     /// The x knot array for the first flavor grid of the lowest-Q2 subgrid is returned.
     const vector<double>& xKnots() const {
+      _ensureData();
       const KnotArrayNF& subgrid1 = _knotarrays.begin()->second;
       const KnotArray1F& grid1 = subgrid1.get_first();
       return grid1.xs();
@@ -183,7 +311,8 @@ namespace LHAPDF {
 
     /// @brief Return a representative list of interpolation knots in Q2
     ///
-    /// Constructed and cached by walking over all subgrids and concatenating their Q2 lists: expensive!
+    /// Constructed and cached by walking over all subgrids and concatenating their Q2 lists,
+    /// along with the subgrid lookup tables.
     const vector<double>& q2Knots() const;
 
   public:
@@ -218,6 +347,38 @@ namespace LHAPDF {
     /// Caching vector of Q2 knot values
     mutable std::vector<double> _q2knots;
 
+    /// Whether the grid data has been loaded (false only while lazy loading is pending)
+    mutable std::atomic<bool> _dataloaded{true};
+
+    /// Guard for the one-time deferred loading of the grid data
+    mutable std::once_flag _dataonce;
+
+    /// @brief Where the grid data of a lazily-loaded ASCII member starts
+    ///
+    /// The number of metadata header lines and the byte offset after them, noted
+    /// while reading the header so the deferred load can seek straight past it.
+    /// The offset is negative if the stream couldn't report it, e.g. when compressed.
+    int _nheaderlines = 0;
+    std::streamoff _dataoffset = -1;
+
+    /// Lower Q2 edges of the subgrids, for constant-time subgrid lookup
+    mutable std::vector<double> _subgridq2s;
+
+    /// The subgrids, in the same order as their Q2 edges
+    mutable std::vector<const KnotArrayNF*> _subgridptrs;
+
+    /// Index table for the subgrid Q2 edges
+    mutable KnotIndex _subgridindex;
+
+    /// Whether the subgrid lookup tables are up to date
+    mutable std::atomic<bool> _subgridsindexed{false};
+
+    /// Guard for rebuilding the subgrid lookup tables
+    mutable std::mutex _subgridmutex;
+
+    /// Number of times the subgrid lookup tables have been built, as the grid generation number
+    mutable std::atomic<size_t> _gridgeneration{0};
+
     /// Typedef of smart pointer for ipol memory handling
     typedef unique_ptr<Interpolator> InterpolatorPtr;
 
@@ -10,6 +10,11 @@
 #include "LHAPDF/Utils.h"
 #include "LHAPDF/Paths.h"
 #include "LHAPDF/Exceptions.h"
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <typeinfo>
+#include <functional>
 
 namespace LHAPDF {
 
@@ -50,6 +55,13 @@ namespace LHAPDF {
     /// YAML source files. Values for existing keys will be overwritten.
     void load(const std::string& filepath);
 
+    /// @brief Populate this info object from the YAML document at the start of a stream
+    ///
+    /// Reading stops after the first "---" document separator, so the stream
+    /// is left positioned at the start of any following data blocks. The
+    /// @a name is used in error messages.
+    void load(std::istream& stream, const std::string& name);
+
     ///@}
 
 
@@ -105,29 +117,36 @@ namespace LHAPDF {
 
 
     /// Retrieve a metadata string by key name, with a default fallback
+    ///
+    /// Missing keys are detected with has_key() rather than by catching the
+    /// lookup exception, so the fallback path is cheap.
     virtual const std::string& get_entry(const std::string& key, const std::string& fallback) const {
-      try {
-        return get_entry(key);
-      } catch (...) {
-        return fallback;
-      }
+      if (!has_key(key)) return fallback;
+      return get_entry(key);
     }
 
 
     /// Retrieve a metadata entry by key name, with an inline type cast
     ///
-    /// Specialisations are defined below for unpacking of comma-separated lists
-    /// of strings, ints, and doubles.
+    /// Each entry is parsed only once per type: the result is cached along with
+    /// the string it was parsed from, and is reparsed only if that string
+    /// changes, e.g. via set_entry() or a change in a fallback set or config
+    /// entry. Specialisations of the parsing are defined below for unpacking of
+    /// comma-separated lists of strings, ints, and doubles.
+    ///
+    /// @note The returned reference is to the cached value, and is valid until
+    /// the next non-const operation on this Info object.
     template <typename T>
-    T get_entry_as(const std::string& key) const {
+    const T& get_entry_as(const std::string& key) const {
       const string& s = get_entry(key);
-      return lexical_cast<T>(s);
+      return _typedcache.get<T>(key, s);
     }
 
 
     /// Retrieve a metadata entry by key name, with an inline type cast and default fallback
     template <typename T>
     T get_entry_as(const std::string& key, const T& fallback) const {
+      if (!has_key(key)) return fallback;
       try {
         return get_entry_as<T>(key);
       } catch (...) {
@@ -140,6 +159,7 @@ namespace LHAPDF {
     template <typename T>
     void set_entry(const std::string& key, const T& val) {
       _metadict[key] = to_str(val);
+      _changed();
     }
 
     ///@}
@@ -147,9 +167,131 @@ namespace LHAPDF {
 
   protected:
 
+    /// Parse a metadata string as type T
+    template <typename T>
+    static T _parse(const std::string& s) {
+      return lexical_cast<T>(s);
+    }
+
+
+    /// @brief Note a change to the metadata strings
+    ///
+    /// Invalidates the validation of all cached typed values, since this object's
+    /// strings may be fallbacks for others', and releases this object's
+    /// superseded cached values.
+    void _changed() {
+      _generation.fetch_add(1, std::memory_order_acq_rel);
+      _typedcache.compact();
+    }
+
+    /// Count of changes to the metadata strings of any Info object
+    static std::atomic<uint64_t> _generation;
+
+
+    /// @brief Parse-once cache of typed metadata values
+    ///
+    /// Thread-safe, and lock-free on hits: each parsed value is held in an
+    /// individually allocated, immutable slot, pushed onto the front of a list
+    /// in a fixed hash table of lists, so lookups just walk one short list and
+    /// only a miss takes the lock. A hit is validated by comparing the source
+    /// string with the one the value was parsed from, unless no metadata string
+    /// anywhere has changed since the last such comparison. A miss adds one
+    /// slot, which shadows any stale one for the same key and type: shadowed
+    /// slots, and so references to their values, are kept until compact() is
+    /// called for the next non-const operation on the owning Info. The cache is
+    /// not copied along with its Info object: copies start empty and refill on
+    /// demand.
+    class TypedCache {
+    public:
+
+      TypedCache() { _reset(); }
+      TypedCache(const TypedCache&) { _reset(); }
+      TypedCache& operator = (const TypedCache&) { //< assigned after the owning Info's strings
+        clear();
+        _generation.fetch_add(1, std::memory_order_acq_rel);
+        return *this;
+      }
+
+      /// Get the string @a s for @a key as type T, parsing it only if not already cached
+      template <typename T>
+      const T& get(const std::string& key, const std::string& s) const {
+        const uint64_t generation = _generation.load(std::memory_order_acquire);
+        const Slot* slot = _find(_buckets[_bucket(key)].load(std::memory_order_acquire), key, typeid(T));
+        if (slot != nullptr) {
+          if (slot->checked.load(std::memory_order_relaxed) == generation)
+            return *static_cast<const T*>(slot->value.get());
+          if (slot->src == s) {
+            slot->checked.store(generation, std::memory_order_relaxed);
+            return *static_cast<const T*>(slot->value.get());
+          }
+        }
+        const std::shared_ptr<const void> value = std::make_shared<T>(Info::_parse<T>(s));
+        return *static_cast<const T*>(_publish(key, typeid(T), s, value, generation));
+      }
+
+      /// Release the shadowed values, invalidating any references to them
+      void compact();
+
+      /// Release all the cached values
+      void clear();
+
+    private:
+
+      /// A parsed value, with its key, type and the string it was parsed from
+      struct Slot {
+        Slot(const std::string& k, const std::type_info& t, const std::string& s,
+             const std::shared_ptr<const void>& v, uint64_t generation, const Slot* nxt)
+          : key(k), type(&t), src(s), value(v), checked(generation), next(nxt) { }
+        const std::string key;
+        const std::type_info* type;
+        const std::string src;
+        const std::shared_ptr<const void> value;
+        /// The metadata generation at which @a src was last found to be current
+        mutable std::atomic<uint64_t> checked;
+        /// The next older slot in the same bucket, only relinked by compact()
+        const Slot* next;
+      };
+
+      /// Number of hash buckets, enough for the few dozen keys of a typical set
+      static const size_t NBUCKETS = 64;
+
+      /// The bucket index for @a key
+      static size_t _bucket(const std::string& key) { return std::hash<std::string>()(key) % NBUCKETS; }
+
+      /// The newest slot for @a key and @a type in the list starting at @a slot, or null
+      static const Slot* _find(const Slot* slot, const std::string& key, const std::type_info& type) {
+        for (; slot != nullptr; slot = slot->next)
+          if (*slot->type == type && slot->key == key) return slot;
+        return nullptr;
+      }
+
+      /// Empty all the buckets, without releasing the slots
+      void _reset() {
+        for (std::atomic<const Slot*>& head : _buckets) head.store(nullptr, std::memory_order_release);
+      }
+
+      /// Publish a slot with @a value parsed from @a s, unless a current one was published meanwhile, and return the value
+      const void* _publish(const std::string& key, const std::type_info& type, const std::string& s,
+                           const std::shared_ptr<const void>& value, uint64_t generation) const;
+
+      /// The most recently published slot in each bucket, or null
+      mutable std::atomic<const Slot*> _buckets[NBUCKETS];
+
+      /// All the published slots, which own their values
+      mutable std::vector< std::unique_ptr<Slot> > _slots;
+
+      /// Guard for publishing slots
+      mutable std::mutex _mutex;
+
+    };
+
+
     /// The string -> string native metadata storage container
     std::map<std::string, std::string> _metadict;
 
+    /// Typed values parsed from the metadata, by key
+    TypedCache _typedcache;
+
   };
 
 
@@ -158,22 +300,22 @@ namespace LHAPDF {
   ///@{
 
   template <>
-  inline bool Info::get_entry_as(const std::string& key) const {
-    const string& s = get_entry(key);
+  inline bool Info::_parse(const std::string& s) {
+    // Test the YAML-style boolean strings first, since the stream-based cast
+    // silently returns false for them rather than throwing
+    if (s == "true" || s == "on" || s == "yes") return true;
+    if (s == "false" || s == "off" || s == "no") return false;
     try {
       bool rtn = lexical_cast<bool>(s);
       return rtn;
-    } catch (...) {
-      if (s == "true" || s == "on" || s == "yes") return true;
-      if (s == "false" || s == "off" || s == "no") return false;
-    }
+    } catch (...) { }
     throw MetadataError("'" + s + "' is not a valid string for conversion to bool type");
   }
 
   template <>
-  inline std::vector<std::string> Info::get_entry_as(const std::string& key) const {
+  inline std::vector<std::string> Info::_parse(const std::string& s) {
     static const string delim = ",";
-    string strval = trim(get_entry(key));
+    string strval = trim(s);
     // cout << "@@ " << strval << endl;
     if (startswith(strval, "[")) strval = strval.substr(1, strval.size()-1);
     if (endswith(strval, "]")) strval = strval.substr(0, strval.size()-1);
@@ -182,21 +324,21 @@ namespace LHAPDF {
   }
 
   template <>
-  inline std::vector<int> Info::get_entry_as(const std::string& key) const {
-    const vector<string> strs = get_entry_as< vector<string> >(key);
+  inline std::vector<int> Info::_parse(const std::string& s) {
+    const vector<string> strs = _parse< vector<string> >(s);
     vector<int> rtn;
     rtn.reserve(strs.size());
-    for (const string& s : strs) rtn.push_back( lexical_cast<int>(s) );
+    for (const string& str : strs) rtn.push_back( lexical_cast<int>(str) );
     assert(rtn.size() == strs.size());
     return rtn;
   }
 
   template <>
-  inline std::vector<double> Info::get_entry_as(const std::string& key) const {
-    const vector<string> strs = get_entry_as< vector<string> >(key);
+  inline std::vector<double> Info::_parse(const std::string& s) {
+    const vector<string> strs = _parse< vector<string> >(s);
     vector<double> rtn;
     rtn.reserve(strs.size());
-    for (const string& s : strs) rtn.push_back( lexical_cast<double>(s) );
+    for (const string& str : strs) rtn.push_back( lexical_cast<double>(str) );
     assert(rtn.size() == strs.size());
     return rtn;
   }
@@ -40,6 +40,11 @@ namespace LHAPDF {
     /// Get the associated GridPDF
     const GridPDF& pdf() const { return *_pdf; }
 
+    /// @brief Build any tables derived from the bound PDF's grids now, rather than on first use
+    ///
+    /// Called by GridPDF::freeze. A no-op for interpolators without derived state.
+    virtual void freeze() { }
+
     ///@}
 
 
@@ -54,8 +59,47 @@ namespace LHAPDF {
     /// Interpolate a single-point in (x,Q2)
     double interpolateXQ2(int id, double x, double q2) const;
 
+    /// @brief Interpolate a batch of n (x,Q2) points, all of which must be in the grid range
+    void interpolateXQ2(int id, const double* xs, const double* q2s, double* out, size_t n) const {
+      _interpolateXQ2(id, xs, q2s, out, n);
+    }
+
 
-    /// @todo Make an all-PID version of interpolateQ and Q2?
+    /// @brief Interpolate a single in-range (x,Q2) point for several PIDs
+    ///
+    /// The subgrid and knot indices are looked up only once, and
+    /// interpolators may also share their weights between the flavors.
+    /// Entries of @a out for PIDs not present in the grid are set to zero.
+    void interpolateXQ2(double x, double q2, const int* ids, double* out, size_t nids) const;
+
+    ///@}
+
+
+    /// @name Separable interpolation weights
+    ///
+    /// Interpolators built as a product of one-dimensional schemes can write
+    /// each value as sum_{j,k} wx[j] wq2[k] xf(ix0+j, iq20+k), with weights
+    /// depending only on the knots and the x or Q2 value. Tables on grids of
+    /// points can then be filled by interpolating the needed knot rows to each
+    /// Q2 value once, and then each x value along those rows (see PDF::tabulate).
+    ///@{
+
+    /// Weights of up to four consecutive knots along one axis of a grid
+    struct AxisWeights {
+      size_t i0; //< index of the first knot
+      size_t n; //< number of knots
+      double w[4];
+    };
+
+    /// @brief Get the weights of the x knots for the in-range value @a x
+    ///
+    /// Returns false if this interpolator is not separable.
+    virtual bool _xWeights(const KnotGeometry&, double, AxisWeights&) const { return false; }
+
+    /// @brief Get the weights of the Q2 knots for the in-range value @a q2
+    ///
+    /// Returns false if this interpolator is not separable.
+    virtual bool _q2Weights(const KnotGeometry&, double, AxisWeights&) const { return false; }
 
     ///@}
 
@@ -70,8 +114,33 @@ namespace LHAPDF {
     /// flavour of interpolator.
     virtual double _interpolateXQ2(const KnotArray1F& subgrid, double x, size_t ix, double q2, size_t iq2) const = 0;
 
-    /// @todo Implement this NF version, with a cached KnotArrayNF?
-    // virtual double _interpolateXQ2(const KnotArrayNF& subgrid, int id, double x, size_t ix, double q2, size_t iq2) const;
+    /// @brief Interpolate a batch of n in-range (x,Q2) points
+    ///
+    /// The default implementation loops over the single-point interpolateXQ2:
+    /// override it in interpolators with a vectorisable kernel.
+    virtual void _interpolateXQ2(int id, const double* xs, const double* q2s, double* out, size_t n) const {
+      for (size_t i = 0; i < n; ++i) out[i] = interpolateXQ2(id, xs[i], q2s[i]);
+    }
+
+    /// @brief Interpolate a single point in (x,Q2) for several PIDs, given the subgrid and its x/Q2 indices
+    ///
+    /// The default implementation calls the single-flavor _interpolateXQ2 for
+    /// each PID: override it in interpolators whose weights can be shared.
+    virtual void _interpolateXQ2(const KnotArrayNF& subgrid, double x, size_t ix, double q2, size_t iq2,
+                                 const int* ids, double* out, size_t nids) const;
+
+    /// @brief Copy the result for ids[i] from an earlier PID which is an alias of the same grid
+    ///
+    /// Returns false if there is no such earlier PID, i.e. out[i] must still be computed.
+    static bool _reuseAliased(const KnotArrayNF& subgrid, const KnotArray1F* grid, const int* ids, double* out, size_t i) {
+      for (size_t j = 0; j < i; ++j) {
+        if (subgrid.find_pid(ids[j]) == grid) {
+          out[i] = out[j];
+          return true;
+        }
+      }
+      return false;
+    }
 
 
   private:
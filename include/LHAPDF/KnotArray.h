@@ -8,37 +8,220 @@
 #define LHAPDF_KnotArray_H
 
 #include "LHAPDF/Exceptions.h"
+#include "LHAPDF/Utils.h"
+#include <cstdint>
+#include <atomic>
+#include <cstring>
 
 namespace LHAPDF {
 
 
+  /// @brief Constant-time lookup of the knot interval containing a value
+  ///
+  /// The IEEE 754 bit patterns of non-negative doubles are ordered like their
+  /// values, and roughly linear in their logarithms. Bucketing the sorted knots
+  /// uniformly in bit-pattern space hence gives an approximately uniform
+  /// occupancy for log-spaced grids. Each bucket records the last knot at or
+  /// below its lower edge, and a lookup steps forward over any further knots
+  /// below the value: with several buckets per knot, usually none or one.
+  /// The result is exactly that of a binary search.
+  class KnotIndex {
+  public:
+
+    /// Default constructor, for an index which falls back to binary searches
+    KnotIndex() : _base(0), _shift(0) {}
+
+    /// Build the bucket table for the given sorted knots
+    explicit KnotIndex(const std::vector<double>& knots);
+
+    /// Get the index of the last of the given (indexed) knots <= @a v, which must be >= knots.front()
+    size_t find(const std::vector<double>& knots, double v) const {
+      if (_table.empty())
+        return upper_bound(knots.begin(), knots.end(), v) - knots.begin() - 1;
+      const uint64_t bits = _bits(v);
+      size_t ib = 0;
+      if (bits > _base && bits < SIGNBIT) ib = std::min<uint64_t>((bits - _base) >> _shift, _table.size()-1);
+      size_t i = _table[ib];
+      while (i+1 < knots.size() && knots[i+1] <= v) i += 1;
+      return i;
+    }
+
+  private:
+
+    /// The sign bit of a double's bit pattern
+    static const uint64_t SIGNBIT = 0x8000000000000000ULL;
+
+    /// Bit pattern of a double
+    static uint64_t _bits(double v) {
+      uint64_t u;
+      memcpy(&u, &v, sizeof(u));
+      return u;
+    }
+
+    /// Bit pattern of the first knot
+    uint64_t _base;
+    /// Bit shift from bit-pattern offset to bucket number
+    unsigned int _shift;
+    /// Last knot index at or below each bucket's lower edge
+    std::vector<uint32_t> _table;
+
+  };
+
+
+
+  /// @brief Immutable knot positions of a 2D interpolation grid, shared between arrays
+  ///
+  /// All flavors in a subgrid, and usually all members of a PDF set, have
+  /// identical knots. Rather than each KnotArray1F holding its own copies of
+  /// the x, Q2, log(x) and log(Q2) vectors, geometries are interned: mk()
+  /// returns a reference-counted handle to the single registered instance
+  /// with the given knot values. Handle (or hash) equality can hence be used
+  /// to identify grids which share interpolation weights.
+  class KnotGeometry {
+  public:
+
+    /// Get the interned geometry with the given x and Q2 knots
+    static std::shared_ptr<const KnotGeometry> mk(const std::vector<double>& xknots, const std::vector<double>& q2knots);
+
+    /// Get the (interned) geometry with no knots
+    static const std::shared_ptr<const KnotGeometry>& empty();
+
+    /// Number of distinct geometries currently registered
+    static size_t numRegistered();
+
+
+    /// x knot accessor
+    const std::vector<double>& xs() const { return _xs; }
+    /// log(x) knot accessor
+    const std::vector<double>& logxs() const { return _logxs; }
+
+    /// Q2 knot accessor
+    const std::vector<double>& q2s() const { return _q2s; }
+    /// log(Q2) knot accessor
+    const std::vector<double>& logq2s() const { return _logq2s; }
+
+    /// Hash of the knot values, for fast comparisons and cache validation
+    size_t hash() const { return _hash; }
+
+    /// @brief Get the index of the closest x knot row <= x
+    ///
+    /// If the value is >= x_max, return i_max-1 (for polynomial spine construction)
+    size_t ixbelow(double x) const {
+      // Test that x is in the grid range
+      if (x < xs().front()) throw GridError("x value " + to_str(x) + " is lower than lowest-x grid point at " + to_str(xs().front()));
+      if (x > xs().back()) throw GridError("x value " + to_str(x) + " is higher than highest-x grid point at " + to_str(xs().back()));
+      // Find the closest knot below the requested value
+      size_t i = _xindex.find(_xs, x);
+      if (i+1 == _xs.size()) i -= 1; // can't return the last knot index
+      return i;
+    }
+
+    /// Get the index of the closest Q2 knot row <= q2
+    ///
+    /// If the value is >= q2_max, return i_max-1 (for polynomial spine construction)
+    size_t iq2below(double q2) const {
+      // Test that Q2 is in the grid range
+      if (q2 < q2s().front()) throw GridError("Q2 value " + to_str(q2) + " is lower than lowest-Q2 grid point at " + to_str(q2s().front()));
+      if (q2 > q2s().back()) throw GridError("Q2 value " + to_str(q2) + " is higher than highest-Q2 grid point at " + to_str(q2s().back()));
+      /// Find the closest knot below the requested value
+      size_t i = _q2index.find(_q2s, q2);
+      if (i+1 == _q2s.size()) i -= 1; // can't return the last knot index
+      return i;
+    }
+
+    /// Compute the hash of a set of x and Q2 knot values
+    static size_t computeHash(const std::vector<double>& xknots, const std::vector<double>& q2knots);
+
+
+  private:
+
+    /// Private constructor: use mk() to obtain interned instances
+    KnotGeometry(const std::vector<double>& xknots, const std::vector<double>& q2knots);
+
+    /// List of x knots
+    std::vector<double> _xs;
+    /// List of Q2 knots
+    std::vector<double> _q2s;
+    /// List of log(x) knots
+    std::vector<double> _logxs;
+    /// List of log(Q2) knots
+    std::vector<double> _logq2s;
+    /// Hash of the knot values
+    size_t _hash;
+    /// Constant-time index lookup tables for the x and Q2 knots
+    KnotIndex _xindex, _q2index;
+
+  };
+
+
+
   /// @brief Internal storage class for PDF data point grids
   ///
   /// We use "array" to refer to the "raw" knot grid, while "grid" means a grid-based PDF.
   /// The "1F" means that this is a single-flavour array
+  ///
+  /// The xf values can optionally be held at a reduced storage precision (see
+  /// setPrecision), but are always returned and interpolated as doubles.
   class KnotArray1F {
   public:
 
+    /// @brief Storage precisions for the xf values
+    ///
+    /// The maximum errors on the stored values are:
+    ///  - DOUBLE: none, the values are stored as parsed;
+    ///  - FLOAT: a relative error of 2^-24 = 6.0e-8 (below the ~7 significant
+    ///    digits of the data files), for |xf| above the 1.2e-38 float limit;
+    ///  - LOG16: a 16-bit sign and log2|xf| code, scaled for each block of
+    ///    LOG16BLOCK values. The relative error is at most
+    ///    2^(r/65532) - 1 for a block spanning r in log2|xf|, and the range is
+    ///    capped at LOG16RANGE = 40, i.e. at most 4.3e-4. Values below
+    ///    2^-40 times the largest |xf| in their block are stored as zero.
+    ///    Decoding costs some arithmetic per value read, so this mode trades
+    ///    interpolation speed for a quarter of the DOUBLE memory footprint.
+    enum Precision { DOUBLE, FLOAT, LOG16 };
+
+    /// Number of consecutive values sharing a LOG16 scale
+    static const size_t LOG16BLOCK = 32;
+
+    /// Maximum log2 range of |xf| values in a LOG16 block
+    static constexpr double LOG16RANGE = 40.0;
+
     /// Default constructor just for std::map insertability
-    KnotArray1F() {}
+    KnotArray1F() : _geom(KnotGeometry::empty()), _xfstride(1), _precision(DOUBLE), _version(_nextVersion()) {}
 
     /// Constructor from x and Q2 knot values, and an xf value grid as strided list
     KnotArray1F(const std::vector<double>& xknots, const std::vector<double>& q2knots, const std::vector<double>& xfs)
-      : _xs(xknots), _q2s(q2knots), _xfs(xfs)
+      : _geom(KnotGeometry::mk(xknots, q2knots)), _xfs(xfs), _xfstride(1), _precision(DOUBLE), _version(_nextVersion())
     {
       assert(_xfs.size() == size());
-      _synclogs();
     }
 
     /// Constructor of a zero-valued array from x and Q2 knot values
     KnotArray1F(const std::vector<double>& xknots, const std::vector<double>& q2knots)
-      : _xs(xknots), _q2s(q2knots),
-        _xfs(size(), 0.0)
+      : _geom(KnotGeometry::mk(xknots, q2knots)),
+        _xfs(size(), 0.0), _xfstride(1), _precision(DOUBLE), _version(_nextVersion())
     {
       assert(_xfs.size() == size());
-      _synclogs();
     }
 
+    /// Constructor of a zero-valued array from a shared knot geometry
+    KnotArray1F(const std::shared_ptr<const KnotGeometry>& geom)
+      : _geom(geom), _xfs(size(), 0.0), _xfstride(1), _precision(DOUBLE), _version(_nextVersion())
+    {    }
+
+
+    /// Get the shared knot geometry of this array
+    const std::shared_ptr<const KnotGeometry>& geometry() const { return _geom; }
+
+    /// @brief Stamp of the current knots and xf values
+    ///
+    /// Changed by every non-const access to them, to a value unique across all
+    /// arrays, so that tables derived from an array can be checked against it.
+    /// A copy has the same stamp as its original, since it has the same values.
+    /// Values changed through a reference from an earlier xfs() call, made before
+    /// the derived tables were last used, are not detected: call xfs() again.
+    uint64_t version() const { return _version; }
+
 
     /// @name x stuff
     ///@{
@@ -46,33 +229,23 @@ namespace LHAPDF {
     /// x knot setter
     /// @note Also zeros the xfs array, which is invalidated by resetting the x knots
     void setxs(const std::vector<double>& xs) {
-      _xs = xs;
-      _synclogs();
-      _xfs = std::vector<double>(size(), 0.0);
+      _geom = KnotGeometry::mk(xs, q2s());
+      _resetxfs();
     }
 
     /// Number of x knots
-    size_t xsize() const { return _xs.size(); }
+    size_t xsize() const { return xs().size(); }
 
     /// x knot accessor
-    const std::vector<double>& xs() const { return _xs; }
+    const std::vector<double>& xs() const { return _geom->xs(); }
 
     /// log(x) knot accessor
-    const std::vector<double>& logxs() const { return _logxs; }
+    const std::vector<double>& logxs() const { return _geom->logxs(); }
 
     /// @brief Get the index of the closest x knot row <= x
     ///
     /// If the value is >= x_max, return i_max-1 (for polynomial spine construction)
-    size_t ixbelow(double x) const {
-      // Test that x is in the grid range
-      if (x < xs().front()) throw GridError("x value " + to_str(x) + " is lower than lowest-x grid point at " + to_str(xs().front()));
-      if (x > xs().back()) throw GridError("x value " + to_str(x) + " is higher than highest-x grid point at " + to_str(xs().back()));
-      // Find the closest knot below the requested value
-      size_t i = upper_bound(xs().begin(), xs().end(), x) - xs().begin();
-      if (i == xs().size()) i -= 1; // can't return the last knot index
-      i -= 1; // have to step back to get the knot <= x behaviour
-      return i;
-    }
+    size_t ixbelow(double x) const { return _geom->ixbelow(x); }
 
     ///@}
 
@@ -83,33 +256,23 @@ namespace LHAPDF {
     /// Q2 knot setter
     /// @note Also zeros the xfs array, which is invalidated by resetting the Q2 knots
     void setq2s(const std::vector<double>& q2s) {
-      _q2s = q2s;
-      _synclogs();
-      _xfs = std::vector<double>(size(), 0.0);
+      _geom = KnotGeometry::mk(xs(), q2s);
+      _resetxfs();
     }
 
     /// Number of Q2 knots
-    size_t q2size() const { return _q2s.size(); }
+    size_t q2size() const { return q2s().size(); }
 
     /// Q2 knot accessor
-    const std::vector<double>& q2s() const { return _q2s; }
+    const std::vector<double>& q2s() const { return _geom->q2s(); }
 
     /// log(Q2) knot accessor
-    const std::vector<double>& logq2s() const { return _logq2s; }
+    const std::vector<double>& logq2s() const { return _geom->logq2s(); }
 
     /// Get the index of the closest Q2 knot row <= q2
     ///
     /// If the value is >= q2_max, return i_max-1 (for polynomial spine construction)
-    size_t iq2below(double q2) const {
-      // Test that Q2 is in the grid range
-      if (q2 < q2s().front()) throw GridError("Q2 value " + to_str(q2) + " is lower than lowest-Q2 grid point at " + to_str(q2s().front()));
-      if (q2 > q2s().back()) throw GridError("Q2 value " + to_str(q2) + " is higher than highest-Q2 grid point at " + to_str(q2s().back()));
-      /// Find the closest knot below the requested value
-      size_t i = upper_bound(q2s().begin(), q2s().end(), q2) - q2s().begin();
-      if (i == q2s().size()) i -= 1; // can't return the last knot index
-      i -= 1; // have to step back to get the knot <= q2 behaviour
-      return i;
-    }
+    size_t iq2below(double q2) const { return _geom->iq2below(q2); }
 
     ///@}
 
@@ -120,39 +283,175 @@ namespace LHAPDF {
     /// Number of x knots
     size_t size() const { return xsize()*q2size(); }
 
-    /// xf value accessor (const)
-    const std::vector<double>& xfs() const { return _xfs; }
-    /// xf value accessor (non-const)
-    std::vector<double>& xfs() { return _xfs; }
+    /// @brief xf value accessor (const)
+    ///
+    /// @note Only available for locally-owned, double-precision storage: use
+    /// xf(ix, iq2) for arrays which view shared data, e.g. from a
+    /// flavor-interleaved KnotArrayNF, or which are stored at reduced precision.
+    const std::vector<double>& xfs() const {
+      if (shared())
+        throw GridError("Direct xf vector access is not possible for a KnotArray1F viewing shared storage");
+      if (_precision != DOUBLE)
+        throw GridError("Direct xf vector access is not possible for a KnotArray1F with reduced-precision storage");
+      return _xfs;
+    }
+
+    /// @brief xf value accessor (non-const)
+    ///
+    /// If the xf values are currently viewed from shared storage, or stored at
+    /// reduced precision, they are first copied into a locally-owned double array.
+    std::vector<double>& xfs() {
+      _version = _nextVersion(); //< the values may be changed through the returned reference
+      if (shared() || _precision != DOUBLE) {
+        std::vector<double> tmp(size());
+        for (size_t i = 0; i < tmp.size(); ++i) tmp[i] = xf(i / q2size(), i % q2size());
+        setxfs(tmp);
+      }
+      return _xfs;
+    }
+
     /// xf value setter
-    void setxfs(const std::vector<double>& xfs) { _xfs = xfs; }
+    void setxfs(const std::vector<double>& xfs) {
+      _version = _nextVersion();
+      _xfs = xfs;
+      _xfshared.reset();
+      _xfstride = 1;
+      _releaseCompact();
+    }
 
-    /// Get the xf value at a particular indexed x,Q2 knot
-    const double& xf(size_t ix, size_t iq2) const { return _xfs[ix*q2size() + iq2]; }
+    /// @brief Use externally owned xf storage, with a stride between consecutive (ix,iQ2) entries
+    ///
+    /// The data pointer must remain valid for the lifetime of the shared_ptr
+    /// handle: the aliasing shared_ptr constructor can be used to point into
+    /// an array with a different owner. Any locally-owned xf values are released.
+    void setxfs(const std::shared_ptr<const double>& xfdata, size_t stride=1) {
+      _version = _nextVersion();
+      _xfshared = xfdata;
+      _xfstride = stride;
+      std::vector<double>().swap(_xfs);
+      _releaseCompact();
+    }
+
+    /// Is the xf data held in shared (and possibly strided) external storage?
+    bool shared() const { return bool(_xfshared); }
+
+    /// Stride between consecutive xf values in the (possibly shared) storage
+    size_t xfstride() const { return _xfstride; }
+
+    /// @brief Get the xf value at a particular indexed x,Q2 knot
+    ///
+    /// @note Returned by value, since reduced-precision values are decoded on
+    /// the fly: in earlier versions this returned a const reference.
+    double xf(size_t ix, size_t iq2) const {
+      const size_t i = ix*q2size() + iq2;
+      if (_precision == DOUBLE) {
+        const double* data = shared() ? _xfshared.get() : _xfs.data();
+        return data[i*_xfstride];
+      }
+      if (_precision == FLOAT) return _xfsfloat[i];
+      return _decodeLog16(i);
+    }
+
+    ///@}
+
+
+    /// @name Storage precision
+    ///@{
+
+    /// @brief Re-encode the xf values at storage precision @a prec
+    ///
+    /// Any shared storage is released, and the values are copied into a
+    /// locally-owned array. Converting back to a higher precision does not
+    /// recover the original values. A GridError is thrown if LOG16 storage is
+    /// requested for non-finite xf values.
+    void setPrecision(Precision prec);
+
+    /// The current storage precision of the xf values
+    Precision precision() const { return _precision; }
 
     ///@}
 
 
   private:
 
-    /// Synchronise log(x) and log(Q2) arrays from the x and Q2 ones
-    void _synclogs() {
-      _logxs.resize(_xs.size());
-      _logq2s.resize(_q2s.size());
-      for (size_t i = 0; i < _xs.size(); ++i) _logxs[i] = log(_xs[i]);
-      for (size_t i = 0; i < _q2s.size(); ++i) _logq2s[i] = log(_q2s[i]);
+    /// Reset the xf values to a zero-valued local array, e.g. after knot resizing
+    void _resetxfs() {
+      _version = _nextVersion();
+      _xfs = std::vector<double>(size(), 0.0);
+      _xfshared.reset();
+      _xfstride = 1;
+      _releaseCompact();
     }
 
-    /// List of x knots
-    std::vector<double> _xs;
-    /// List of Q2 knots
-    std::vector<double> _q2s;
-    /// List of log(x) knots
-    std::vector<double> _logxs;
-    /// List of log(Q2) knots
-    std::vector<double> _logq2s;
+    /// Next value of the process-wide version stamp counter
+    static uint64_t _nextVersion() {
+      static std::atomic<uint64_t> next{0};
+      return ++next;
+    }
+
+    /// Release any reduced-precision storage, and mark the array as DOUBLE
+    void _releaseCompact() {
+      std::vector<float>().swap(_xfsfloat);
+      std::vector<uint16_t>().swap(_xfslog16);
+      std::vector<double>().swap(_log16scales);
+      _precision = DOUBLE;
+    }
+
+    /// Decode the LOG16 value at flat index @a i
+    double _decodeLog16(size_t i) const {
+      const uint16_t code = _xfslog16[i];
+      const uint16_t mag = code & 0x7fff;
+      if (mag == 0) return 0.0;
+      const double* scale = &_log16scales[2*(i / LOG16BLOCK)];
+      const double v = _exp2(scale[0] + (mag - 1)*scale[1]);
+      return (code & 0x8000) ? -v : v;
+    }
+
+    /// @brief Fast 2^t, accurate to a relative 1e-12 (far below the LOG16 quantisation)
+    ///
+    /// Splits t into an integer exponent and a remainder in [-0.5, 0.5), whose
+    /// power of two is a Taylor series in r*ln(2).
+    static double _exp2(double t) {
+      const double n = std::floor(t + 0.5);
+      if (!(n > -1022 && n < 1023)) return std::exp2(t); //< out of the normal range
+      const double y = (t - n) * M_LN2;
+      double p = 1.0/3628800;
+      p = p*y + 1.0/362880;
+      p = p*y + 1.0/40320;
+      p = p*y + 1.0/5040;
+      p = p*y + 1.0/720;
+      p = p*y + 1.0/120;
+      p = p*y + 1.0/24;
+      p = p*y + 1.0/6;
+      p = p*y + 0.5;
+      p = p*y + 1.0;
+      p = p*y + 1.0;
+      const uint64_t bits = uint64_t(int64_t(n) + 1023) << 52;
+      double scale;
+      std::memcpy(&scale, &bits, sizeof(double));
+      return p * scale;
+    }
+
+    /// Shared x, Q2, log(x) and log(Q2) knot arrays
+    std::shared_ptr<const KnotGeometry> _geom;
     /// List of xf values across the 2D knot array, stored as a strided [ix][iQ2] 1D array
     std::vector<double> _xfs;
+    /// Handle on xf values held in external (e.g. flavor-interleaved) storage, if set
+    std::shared_ptr<const double> _xfshared;
+    /// Stride between consecutive [ix][iQ2] entries in the xf storage
+    size_t _xfstride;
+
+    /// Storage precision of the xf values
+    Precision _precision;
+    /// xf values in FLOAT storage
+    std::vector<float> _xfsfloat;
+    /// xf values in LOG16 storage: a sign bit and a 15-bit log2|xf| code, or 0 for zero
+    std::vector<uint16_t> _xfslog16;
+    /// Minimum log2|xf| and log2 step of each LOG16 block, interleaved
+    std::vector<double> _log16scales;
+
+    /// Stamp of the current knots and xf values
+    uint64_t _version;
 
   };
 
@@ -160,24 +459,72 @@ namespace LHAPDF {
   /// @brief A collection of {KnotArray1F}s accessed by PID code
   ///
   /// The "NF" means "> 1 flavour", cf. the KnotArray1F name for a single flavour data array.
+  ///
+  /// By default each flavor owns its own xf array. Calling interleave() switches
+  /// to an alternative storage layout, in which the xf values of all flavors are
+  /// held in a single contiguous [ix][iQ2][flavor] array, viewed with a stride by
+  /// each of the KnotArray1F objects. An all-flavor lookup of the same (ix,iQ2)
+  /// stencil then reads neighbouring memory rather than one block per flavor.
+  ///
+  /// Flavors with identical grids can also be stored once, with the other PIDs
+  /// set up as aliases which resolve to the same KnotArray1F object.
   class KnotArrayNF {
   public:
 
-    /// How many {KnotArray1F}s are stored in this container?
-    size_t size() const { return _map.size(); }
+    /// Default constructor
+    KnotArrayNF() : _interleaved(false) {
+      _resetSlots();
+    }
+
+    /// Copy constructor, pointing the PID slots at the new copies
+    KnotArrayNF(const KnotArrayNF& other)
+      : _map(other._map), _aliases(other._aliases), _interleaved(other._interleaved),
+        _pids(other._pids), _xfdata(other._xfdata)
+    {
+      _resetSlots();
+    }
+
+    /// Copy assignment, pointing the PID slots at the new copies
+    KnotArrayNF& operator = (const KnotArrayNF& other) {
+      if (this == &other) return *this;
+      _map = other._map;
+      _aliases = other._aliases;
+      _interleaved = other._interleaved;
+      _pids = other._pids;
+      _xfdata = other._xfdata;
+      _resetSlots();
+      return *this;
+    }
+
+    /// How many flavors are defined in this container, including aliases?
+    size_t size() const { return _map.size() + _aliases.size(); }
 
     /// Is this container empty?
     bool empty() const { return _map.empty(); }
 
     /// Does this contain a KnotArray1F for PID code @a id?
     bool has_pid(int id) const {
-      return _map.find(id) != _map.end();
+      return find_pid(id) != nullptr;
+    }
+
+    /// @brief Get a pointer to the KnotArray1F for PID code @a id, or null if it is not defined
+    ///
+    /// The standard partons are found by a single array index, and only other
+    /// (exotic) PIDs need a map lookup.
+    const KnotArray1F* find_pid(int id) const {
+      const int slot = pidSlot(id);
+      if (slot >= 0) return _slots[slot];
+      std::map<int, KnotArray1F>::const_iterator it = _map.find(id);
+      if (it != _map.end()) return &it->second;
+      std::map<int, int>::const_iterator ia = _aliases.find(id);
+      return (ia != _aliases.end()) ? &_map.find(ia->second)->second : nullptr;
     }
 
     /// Get the KnotArray1F for PID code @a id
     const KnotArray1F& get_pid(int id) const {
-      if (!has_pid(id)) throw FlavorError("Undefined particle ID requested: " + to_str(id));
-      return _map.find(id)->second;
+      const KnotArray1F* ka = find_pid(id);
+      if (ka == nullptr) throw FlavorError("Undefined particle ID requested: " + to_str(id));
+      return *ka;
     }
 
     /// Convenience accessor for any valid subgrid, to get access to the x/Q2/etc. arrays
@@ -188,11 +535,154 @@ namespace LHAPDF {
 
     /// Get the KnotArray1F for PID code @a id
     void set_pid(int id, const KnotArray1F& ka) {
-      _map[id] = ka;
+      (*this)[id] = ka;
+    }
+
+    /// @brief Indexing operator (non-const)
+    ///
+    /// An aliased PID is first given its own copy of the shared array, so that
+    /// modifications through the returned reference only affect this PID.
+    KnotArray1F& operator[](int id) {
+      _interleaved = false;
+      std::map<int, int>::iterator ia = _aliases.find(id);
+      if (ia != _aliases.end()) {
+        const KnotArray1F target = _map[ia->second];
+        _aliases.erase(ia);
+        _map[id] = target;
+      }
+      KnotArray1F& ka = _map[id];
+      const int slot = pidSlot(id);
+      if (slot >= 0) _slots[slot] = &ka;
+      return ka;
+    }
+
+
+    /// @name Flavor aliasing
+    ///@{
+
+    /// @brief Make PID @a id an alias for the stored grid of PID @a target
+    ///
+    /// Any grid separately stored for @a id is released, and aliases of @a id
+    /// are re-pointed at @a target.
+    void alias_pid(int id, int target) {
+      std::map<int, int>::const_iterator it = _aliases.find(target);
+      if (it != _aliases.end()) target = it->second;
+      if (id == target) return;
+      if (_map.find(target) == _map.end())
+        throw GridError("Can't alias PID " + to_str(id) + " to undefined PID " + to_str(target));
+      _map.erase(id);
+      _aliases[id] = target;
+      for (std::map<int, int>::iterator ia = _aliases.begin(); ia != _aliases.end(); ++ia)
+        if (ia->second == id) ia->second = target;
+      _resetSlots();
     }
 
-    /// Indexing operator (non-const)
-    KnotArray1F& operator[](int id) { return _map[id]; }
+    /// @brief Alias each flavor whose grid is bit-identical to that of an earlier-stored flavor
+    ///
+    /// Returns the number of grids released.
+    size_t alias_identical() {
+      std::vector< std::pair<int, int> > aliases;
+      std::vector<int> uniques;
+      for (std::map<int, KnotArray1F>::const_iterator it = _map.begin(); it != _map.end(); ++it) {
+        int target = it->first;
+        for (int u : uniques) {
+          if (_sameGrid(_map.find(u)->second, it->second)) { target = u; break; }
+        }
+        if (target == it->first) uniques.push_back(target);
+        else aliases.push_back(std::make_pair(it->first, target));
+      }
+      for (const std::pair<int, int>& a : aliases) alias_pid(a.first, a.second);
+      return aliases.size();
+    }
+
+    /// Are the grids of the defined PIDs @a a and @a b bit-identical, including their knots?
+    bool same_grid(int a, int b) const { return _sameGrid(get_pid(a), get_pid(b)); }
+
+    /// Is PID @a id an alias of another stored PID?
+    bool is_alias(int id) const { return _aliases.find(id) != _aliases.end(); }
+
+    /// Are any PIDs in this container aliases?
+    bool has_aliases() const { return !_aliases.empty(); }
+
+    ///@}
+
+
+    /// @name Flavor-interleaved storage
+    ///@{
+
+    /// @brief Repack the xf values of all flavors into one contiguous [ix][iQ2][flavor] array
+    ///
+    /// All flavors must share the same (interned) knot geometry, i.e. have
+    /// identical x and Q2 knots, or a GridError is thrown. The per-flavor
+    /// KnotArray1F objects remain valid, as strided views into the shared array.
+    void interleave() {
+      if (empty() || _interleaved) return;
+      const size_t nflavs = _map.size(); //< aliases share their target's values
+      const size_t npoints = get_first().size();
+      const size_t nq2s = get_first().q2size();
+      std::shared_ptr< std::vector<double> > buf = std::make_shared< std::vector<double> >(npoints*nflavs);
+      _pids.clear();
+      size_t iflav = 0;
+      for (std::map<int, KnotArray1F>::const_iterator it = _map.begin(); it != _map.end(); ++it, ++iflav) {
+        const KnotArray1F& ka = it->second;
+        if (ka.geometry() != geometry())
+          throw GridError("Can't interleave flavor grids with different knot arrays (PID = " + to_str(it->first) + ")");
+        for (size_t i = 0; i < npoints; ++i)
+          (*buf)[i*nflavs + iflav] = ka.xf(i / nq2s, i % nq2s);
+        _pids.push_back(it->first);
+      }
+      _xfdata = std::shared_ptr<const double>(buf, buf->data());
+      iflav = 0;
+      for (std::map<int, KnotArray1F>::iterator it = _map.begin(); it != _map.end(); ++it, ++iflav)
+        it->second.setxfs(std::shared_ptr<const double>(_xfdata, _xfdata.get() + iflav), nflavs);
+      _interleaved = true;
+      _resetFlavorIndices();
+    }
+
+    /// @brief Re-encode the xf values of all stored flavors at storage precision @a prec
+    ///
+    /// Each flavor gets its own storage, i.e. any interleaving is undone.
+    void setPrecision(KnotArray1F::Precision prec) {
+      for (std::map<int, KnotArray1F>::iterator it = _map.begin(); it != _map.end(); ++it)
+        it->second.setPrecision(prec);
+      _interleaved = false;
+      _pids.clear();
+      _xfdata.reset();
+      _resetFlavorIndices();
+    }
+
+    /// Are the flavor xf arrays currently stored in interleaved form?
+    bool interleaved() const { return _interleaved; }
+
+    /// @brief PID codes in the order of the flavor index in interleaved storage
+    ///
+    /// Only valid when interleaved() is true. Aliased PIDs are not included.
+    const std::vector<int>& pids() const { return _pids; }
+
+    /// @brief Pointer to the nflavs contiguous xf values (in pids() order) at knot (ix,iQ2)
+    ///
+    /// Only valid when interleaved() is true.
+    const double* xfs(size_t ix, size_t iq2) const {
+      return _xfdata.get() + (ix*get_first().q2size() + iq2)*_pids.size();
+    }
+
+    /// @brief Index of the xf value for PID @a id in each xfs(ix,iq2) block, or -1 if it is undefined
+    ///
+    /// Aliased PIDs resolve to the index of their target. Only valid when interleaved() is true.
+    int flavorIndex(int id) const {
+      const int slot = pidSlot(id);
+      if (slot >= 0) return _iflavs[slot];
+      std::map<int, int>::const_iterator ia = _aliases.find(id);
+      const int target = (ia != _aliases.end()) ? ia->second : id;
+      const std::vector<int>::const_iterator ip = std::find(_pids.begin(), _pids.end(), target);
+      return (ip != _pids.end()) ? int(ip - _pids.begin()) : -1;
+    }
+
+    ///@}
+
+
+    /// Get the knot geometry (shared by all flavors, as required for interleaving)
+    const std::shared_ptr<const KnotGeometry>& geometry() const { return get_first().geometry(); }
 
     /// Access the xs array
     const std::vector<double>& xs() const { return get_first().xs(); }
@@ -210,9 +700,68 @@ namespace LHAPDF {
 
   private:
 
+    /// Point the PID slots at the stored arrays
+    void _resetSlots() {
+      std::fill(_slots, _slots + NPIDSLOTS, nullptr);
+      for (std::map<int, KnotArray1F>::const_iterator it = _map.begin(); it != _map.end(); ++it) {
+        const int slot = pidSlot(it->first);
+        if (slot >= 0) _slots[slot] = &it->second;
+      }
+      for (std::map<int, int>::const_iterator ia = _aliases.begin(); ia != _aliases.end(); ++ia) {
+        const int slot = pidSlot(ia->first);
+        if (slot >= 0) _slots[slot] = &_map.find(ia->second)->second;
+      }
+      _resetFlavorIndices();
+    }
+
+    /// Point the PID slots at the flavor indices of the interleaved storage
+    void _resetFlavorIndices() {
+      std::fill(_iflavs, _iflavs + NPIDSLOTS, -1);
+      for (size_t i = 0; i < _pids.size(); ++i) {
+        const int slot = pidSlot(_pids[i]);
+        if (slot >= 0) _iflavs[slot] = int(i);
+      }
+      for (std::map<int, int>::const_iterator ia = _aliases.begin(); ia != _aliases.end(); ++ia) {
+        const int slot = pidSlot(ia->first), tslot = pidSlot(ia->second);
+        if (slot < 0) continue;
+        if (tslot >= 0) { _iflavs[slot] = _iflavs[tslot]; continue; }
+        const std::vector<int>::const_iterator ip = std::find(_pids.begin(), _pids.end(), ia->second);
+        _iflavs[slot] = (ip != _pids.end()) ? int(ip - _pids.begin()) : -1;
+      }
+    }
+
+    /// Do two arrays have the same knots and bit-identical xf values?
+    static bool _sameGrid(const KnotArray1F& a, const KnotArray1F& b) {
+      if (a.geometry() != b.geometry() && (a.xs() != b.xs() || a.q2s() != b.q2s())) return false;
+      for (size_t ix = 0; ix < a.xsize(); ++ix)
+        for (size_t iq2 = 0; iq2 < a.q2size(); ++iq2) {
+          const double va = a.xf(ix, iq2), vb = b.xf(ix, iq2);
+          if (std::memcmp(&va, &vb, sizeof(double)) != 0) return false;
+        }
+      return true;
+    }
+
     /// Storage
     std::map<int, KnotArray1F> _map;
 
+    /// Aliased PIDs, mapped to the stored PID whose array they share
+    std::map<int, int> _aliases;
+
+    /// Pointers into the storage map for the standard PIDs, by pidSlot()
+    const KnotArray1F* _slots[NPIDSLOTS];
+
+    /// Flavor indices in the interleaved storage for the standard PIDs, by pidSlot(), or -1
+    int _iflavs[NPIDSLOTS];
+
+    /// Whether the flavor arrays are views into the interleaved _xfdata array
+    bool _interleaved;
+
+    /// Flavor ordering of the interleaved array
+    std::vector<int> _pids;
+
+    /// Interleaved [ix][iQ2][flavor] xf array, shared with the KnotArray1F views
+    std::shared_ptr<const double> _xfdata;
+
   };
 
 
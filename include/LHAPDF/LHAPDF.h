@@ -13,6 +13,8 @@
 #include "LHAPDF/Version.h"
 #include "LHAPDF/PDF.h"
 #include "LHAPDF/PDFSet.h"
+#include "LHAPDF/PDFSetEvaluator.h"
+#include "LHAPDF/ParallelEval.h"
 #include "LHAPDF/PDFInfo.h"
 #include "LHAPDF/Factories.h"
 #include "LHAPDF/PDFIndex.h"
@@ -0,0 +1,98 @@
+// -*- C++ -*-
+//
+// This file is part of LHAPDF
+// Copyright (C) 2012-2019 The LHAPDF collaboration (see AUTHORS for details)
+//
+#pragma once
+#ifndef LHAPDF_LogBicubicCoeffInterpolator_H
+#define LHAPDF_LogBicubicCoeffInterpolator_H
+
+#include "LHAPDF/LogBicubicInterpolator.h"
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+
+namespace LHAPDF {
+
+
+  /// @brief Log-bicubic interpolation from precomputed per-cell polynomial coefficients
+  ///
+  /// The same interpolant as LogBicubicInterpolator, but with the finite-difference
+  /// derivatives and Hermite splines of each (ix,iQ2) grid cell expanded once,
+  /// on first use, into the 16 coefficients of a bicubic polynomial in the
+  /// log-space fractions (t_x, t_Q2). Each evaluation is then a cell lookup and
+  /// a 4x4 polynomial evaluation. Results agree with LogBicubicInterpolator up
+  /// to rounding.
+  ///
+  /// @note The tables hold 16 doubles per cell and flavor, i.e. 16 times the
+  /// memory of the grid values themselves at double precision (and more
+  /// relative to reduced-precision storage), in addition to the grid values.
+  ///
+  /// Selected with the interpolator name "logcubiccoeffs". All tables are
+  /// rebuilt on next use whenever the subgrids are reloaded or restructured,
+  /// via GridPDF::gridGeneration, and each table is rebuilt on next use if the
+  /// version stamp of its flavor grid has changed, e.g. after its values were
+  /// edited through KnotArray1F::xfs. The grid values must not be changed
+  /// while interpolations are in progress.
+  class LogBicubicCoeffInterpolator : public LogBicubicInterpolator {
+  public:
+
+    /// Build the coefficient tables of all the bound PDF's grids now
+    void freeze() override { _buildCoeffs(); }
+
+    /// Implementation of (x,Q2) interpolation
+    double _interpolateXQ2(const KnotArray1F& subgrid, double x, size_t ix, double q2, size_t iq2) const;
+
+    /// Implementation of multi-flavor (x,Q2) interpolation
+    void _interpolateXQ2(const KnotArrayNF& subgrid, double x, size_t ix, double q2, size_t iq2,
+                         const int* ids, double* out, size_t nids) const;
+
+    /// Implementation of batched (x,Q2) interpolation
+    void _interpolateXQ2(int id, const double* xs, const double* q2s, double* out, size_t n) const;
+
+
+  private:
+
+    /// Build the coefficient tables of all the bound PDF's grids, if not already done for their current generation
+    void _buildCoeffs() const;
+
+    /// Get the coefficient table of @a grid, building all tables on first use, and this one again if it is stale
+    const double* _coeffs(const KnotArray1F& grid) const;
+
+    /// Compute the coefficients of all cells of @a grid, as [ix][iQ2][iQ2 power][x power]
+    static void _computeCoeffs(const KnotArray1F& grid, std::vector<double>& coeffs);
+
+    /// Evaluate the cell polynomial at the stencil's (t_x, t_Q2)
+    static double _evalCell(const double* coeffs, const Stencil& s) {
+      const double* c = coeffs + 16*(s.ix*(s.nq2knots-1) + s.iq2);
+      const double tx = s.tlogx, tq = s.tlogq;
+      const double c0 = ((c[3]*tx + c[2])*tx + c[1])*tx + c[0];
+      const double c1 = ((c[7]*tx + c[6])*tx + c[5])*tx + c[4];
+      const double c2 = ((c[11]*tx + c[10])*tx + c[9])*tx + c[8];
+      const double c3 = ((c[15]*tx + c[14])*tx + c[13])*tx + c[12];
+      return ((c3*tq + c2)*tq + c1)*tq + c0;
+    }
+
+    /// Coefficients of one flavor grid, and the grid's version stamp when they were computed
+    struct CoeffTable {
+      std::vector<double> coeffs;
+      std::atomic<uint64_t> version{0};
+    };
+
+    /// Compute the coefficients of @a grid into @a table, if they are missing or stale
+    static void _updateCoeffs(const KnotArray1F& grid, CoeffTable& table);
+
+    /// Coefficient tables, by flavor grid
+    mutable std::unordered_map<const KnotArray1F*, CoeffTable> _coefftables;
+
+    /// Grid generation of the PDF for which the tables were built, or 0 if not yet built
+    mutable std::atomic<size_t> _coeffsgeneration{0};
+
+    /// Guard for building the coefficient tables
+    mutable std::mutex _coeffsmutex;
+
+  };
+
+
+}
+#endif
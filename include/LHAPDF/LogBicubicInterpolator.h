@@ -21,35 +21,226 @@ namespace LHAPDF {
     /// Implementation of (x,Q2) interpolation
     double _interpolateXQ2(const KnotArray1F& subgrid, double x, size_t ix, double q2, size_t iq2) const;
 
-    /// @brief Get the current caching struct for interpolation params
+    /// @brief Implementation of multi-flavor (x,Q2) interpolation
     ///
-    /// @note Meyers Singleton is automatically thread-local since block scope:
-    /// https://www.modernescpp.com/index.php/thread-safe-initialization-of-a-singleton
-    struct XQ2Cache;
-    static XQ2Cache& _getCache() { static XQ2Cache instance; return instance; }
+    /// The stencil is computed once and applied to each flavor grid with the same knots.
+    /// For flavor-interleaved subgrids, the knot values of all flavors are read
+    /// in one pass over the 16 contiguous [flavor] blocks of the neighbourhood.
+    void _interpolateXQ2(const KnotArrayNF& subgrid, double x, size_t ix, double q2, size_t iq2,
+                         const int* ids, double* out, size_t nids) const;
 
-    /// @brief Caching struct definition
+    /// @brief Implementation of batched (x,Q2) interpolation
     ///
-    /// @todo Flavour-specific XQ caching?
-    /// @todo Multi-value caching?
-    /// @todo Cache more ipol-weight variables?
-    struct XQ2Cache {
-      // Defining params from last call (initialised to unphysical values, so first use will set the cache)
-      double x = -1;
+    /// Points are processed in fixed-size blocks: the stencils are computed and
+    /// the 4x4 knot neighbourhoods of points away from the grid edges gathered
+    /// into per-block arrays, and the Hermite arithmetic then run across the
+    /// block as straight-line loops which the compiler can vectorise. Points
+    /// needing one-sided derivatives use the scalar stencil kernel.
+    void _interpolateXQ2(int id, const double* xs, const double* q2s, double* out, size_t n) const;
+
+    /// @brief Get the weights of the x knots for the in-range value @a x
+    ///
+    /// The interpolation is linear in the knot values, so these reproduce
+    /// _interpolateXQ2 up to rounding.
+    bool _xWeights(const KnotGeometry& geom, double x, AxisWeights& aw) const;
+
+    /// Get the weights of the Q2 knots for the in-range value @a q2
+    bool _q2Weights(const KnotGeometry& geom, double q2, AxisWeights& aw) const;
+
+
+    /// @name Flavor-independent interpolation stencils
+    ///
+    /// The interpolation weights depend only on the knot geometry and the
+    /// (x,Q2) point, so they can be computed once and applied to any number of
+    /// flavor or member grids with the same knots. The results are identical
+    /// to those of _interpolateXQ2 only for this exact interpolator type, not
+    /// for derived types such as LogBicubicCoeffInterpolator. This is the API
+    /// for evaluators which hold their own copies of the grid data, such as
+    /// PDFSetEvaluator.
+    ///@{
+
+    /// Knot indices, log-space distances and fractions for one (x,Q2) point
+    struct Stencil {
+      size_t ix, iq2, nxknots, nq2knots;
+      double logx, logq2;
+      double dlogx_1, tlogx;
+      double dlogq_0, dlogq_1, dlogq_2, tlogq;
+      const double* logxs;
+      const double* logq2s;
+    };
+
+    /// Compute the stencil for the given knot geometry, (x,Q2) point and knot indices
+    static void fillStencil(Stencil& s, const KnotGeometry& geom, double x, size_t ix, double q2, size_t iq2);
+
+    /// @brief Interpolate the grid @a arr, which must provide an xf(ix,iq2) accessor, using stencil @a s
+    ///
+    /// The grid must have the knots of the geometry passed to fillStencil.
+    template <typename ARRAY>
+    static double interpolateStencil(const ARRAY& arr, const Stencil& s) {
+      const size_t ix = s.ix, iq2 = s.iq2;
+
+      // Fall back to LogBilinearInterpolator if either 2 or 3 Q-knots
+      if (s.nq2knots < 4) {
+        // First interpolate in x
+        const double logx0 = s.logxs[ix];
+        const double logx1 = s.logxs[ix+1];
+        const double f_ql = _interpolateLinear(s.logx, logx0, logx1, arr.xf(ix, iq2), arr.xf(ix+1, iq2));
+        const double f_qh = _interpolateLinear(s.logx, logx0, logx1, arr.xf(ix, iq2+1), arr.xf(ix+1, iq2+1));
+        // Then interpolate in Q2, using the x-ipol results as anchor points
+        return _interpolateLinear(s.logq2, s.logq2s[iq2], s.logq2s[iq2+1], f_ql, f_qh);
+      }
+      // else proceed with cubic interpolation:
+
+      // Points in Q2
+      const double vl = _interpolateCubicX(arr, s, iq2);
+      const double vh = _interpolateCubicX(arr, s, iq2+1);
+
+      // Derivatives in Q2
+      const size_t iq2max = s.nq2knots - 1;
+      double vdl, vdh;
+      if (iq2 > 0 && iq2+1 < iq2max) {
+        // Central difference for both q
+        /// @note We evaluate the most likely condition first to help compiler branch prediction
+        const double vll = _interpolateCubicX(arr, s, iq2-1);
+        vdl = ( (vh - vl)/s.dlogq_1 + (vl - vll)/s.dlogq_0 ) / 2.0;
+        const double vhh = _interpolateCubicX(arr, s, iq2+2);
+        vdh = ( (vh - vl)/s.dlogq_1 + (vhh - vh)/s.dlogq_2 ) / 2.0;
+      }
+      else if (iq2 == 0) {
+        // Forward difference for lower q
+        vdl = (vh - vl) / s.dlogq_1;
+        // Central difference for higher q
+        const double vhh = _interpolateCubicX(arr, s, iq2+2);
+        vdh = (vdl + (vhh - vh)/s.dlogq_2) / 2.0;
+      }
+      else if (iq2+1 == iq2max) {
+        // Backward difference for higher q
+        vdh = (vh - vl) / s.dlogq_1;
+        // Central difference for lower q
+        const double vll = _interpolateCubicX(arr, s, iq2-1);
+        vdl = (vdh + (vl - vll)/s.dlogq_0) / 2.0;
+      }
+      else throw LogicError("We shouldn't be able to get here!");
+
+      vdl *= s.dlogq_1;
+      vdh *= s.dlogq_1;
+      return _interpolateCubic(s.tlogq, vl, vdl, vh, vdh);
+    }
+
+    ///@}
+
+
+    /// @name Caching of interpolation params
+    ///
+    /// Each thread has one cache, shared by all interpolators, holding the
+    /// last few distinct x and Q2 values with their log-space distances and
+    /// fractions. These depend only on the value and the knots, so entries are
+    /// keyed by the interned knot geometry (and its hash, in case a freed
+    /// geometry's address is reused) and can be reused across flavors, members
+    /// and PDFs with identical knots. Threads never share entries.
+    ///@{
+
+    /// Number of x and of Q2 entries in the cache
+    static const size_t NCACHE = 4;
+
+    /// Cached params for one x value
+    struct XCacheEntry {
+      const KnotGeometry* geom = nullptr; //< knot geometry used to compute the params
+      size_t hash = 0; //< and its hash
+      double x = -1; //< initialised to an unphysical value, so first use will set the entry
       size_t ix = 0;
-      double q2 = -1;
+      double logx, dlogx_1, tlogx;
+    };
+
+    /// Cached params for one Q2 value
+    struct Q2CacheEntry {
+      const KnotGeometry* geom = nullptr; //< knot geometry used to compute the params
+      size_t hash = 0; //< and its hash
+      double q2 = -1; //< initialised to an unphysical value, so first use will set the entry
       size_t iq2 = 0;
-      // Cached params
-      double logx;
-      double logq2;
-      double dlogx_1;
-      double tlogx;
-      double dlogq_0;
-      double dlogq_1;
-      double dlogq_2;
-      double tlogq;
+      double logq2, dlogq_0, dlogq_1, dlogq_2, tlogq;
+    };
+
+    /// Cache of recent x and Q2 params, with round-robin replacement
+    struct XQ2Cache {
+      XCacheEntry xentries[NCACHE];
+      Q2CacheEntry q2entries[NCACHE];
+      size_t nextx = 0, nextq2 = 0;
     };
 
+    /// Get the cache of the current thread
+    static XQ2Cache& _getCache();
+
+    /// Fill the stencil for the given point, using and updating the cache
+    void _fillCachedStencil(Stencil& s, const KnotGeometry& geom, double x, size_t ix, double q2, size_t iq2) const;
+
+    ///@}
+
+
+  protected:
+
+    /// One-dimensional linear interpolation for y(x)
+    static double _interpolateLinear(double x, double xl, double xh, double yl, double yh) {
+      assert(x >= xl);
+      assert(xh >= x);
+      return yl + (x - xl) / (xh - xl) * (yh - yl);
+    }
+
+    /// One-dimensional cubic interpolation
+    static double _interpolateCubic(double T, double VL, double VDL, double VH, double VDH) {
+      // Pre-calculate powers of T
+      const double t2 = T*T;
+      const double t3 = t2*T;
+
+      // Calculate left point
+      const double p0 = (2*t3 - 3*t2 + 1)*VL;
+      const double m0 = (t3 - 2*t2 + T)*VDL;
+
+      // Calculate right point
+      const double p1 = (-2*t3 + 3*t2)*VH;
+      const double m1 = (t3 - t2)*VDH;
+
+      return p0 + m0 + p1 + m1;
+    }
+
+    /// @brief Cubic interpolation in log(x) along a row of four knots, with central differences at both inner knots
+    ///
+    /// The arithmetic is that of _interpolateCubicX for an interior ix,
+    /// written without branches or array access so it can be vectorised.
+    static double _interpolateCubicRow(double f0, double f1, double f2, double f3,
+                                       double dlogx_0, double dlogx_1, double dlogx_2, double tlogx) {
+      const double dxf1 = ((f1 - f0)/dlogx_0 + (f2 - f1)/dlogx_1) / 2.0;
+      const double dxf2 = ((f2 - f1)/dlogx_1 + (f3 - f2)/dlogx_2) / 2.0;
+      return _interpolateCubic(tlogx, f1, dxf1 * dlogx_1, f2, dxf2 * dlogx_1);
+    }
+
+    /// Calculate adjacent d(xf)/dx at all grid locations for fixed iq2
+    ///
+    /// @todo Store pre-cached dlogxs, dlogq2s on subgrids, to replace these denominators? Any real speed gain for the extra memory?
+    template <typename ARRAY>
+    static double _dxf_dlogx(const ARRAY& arr, const Stencil& s, size_t ix, size_t iq2) {
+      const size_t nxknots = s.nxknots;
+      if (ix != 0 && ix != nxknots-1) { //< If central, use the central difference
+        /// @note We evaluate the most likely condition first to help compiler branch prediction
+        const double lddx = (arr.xf(ix, iq2) - arr.xf(ix-1, iq2)) / (s.logxs[ix] - s.logxs[ix-1]);
+        const double rddx = (arr.xf(ix+1, iq2) - arr.xf(ix, iq2)) / (s.logxs[ix+1] - s.logxs[ix]);
+        return (lddx + rddx) / 2.0;
+      } else if (ix == 0) { //< If at leftmost edge, use forward difference
+        return (arr.xf(ix+1, iq2) - arr.xf(ix, iq2)) / (s.logxs[ix+1] - s.logxs[ix]);
+      } else if (ix == nxknots-1) { //< If at rightmost edge, use backward difference
+        return (arr.xf(ix, iq2) - arr.xf(ix-1, iq2)) / (s.logxs[ix] - s.logxs[ix-1]);
+      } else {
+        throw LogicError("We shouldn't be able to get here!");
+      }
+    }
+
+    /// Cubic interpolation in log(x) along the Q2 knot row @a iq2
+    template <typename ARRAY>
+    static double _interpolateCubicX(const ARRAY& arr, const Stencil& s, size_t iq2) {
+      return _interpolateCubic(s.tlogx, arr.xf(s.ix, iq2), _dxf_dlogx(arr, s, s.ix, iq2) * s.dlogx_1,
+                                        arr.xf(s.ix+1, iq2), _dxf_dlogx(arr, s, s.ix+1, iq2) * s.dlogx_1);
+    }
+
   };
 
 
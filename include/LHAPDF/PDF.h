@@ -53,18 +53,31 @@ namespace LHAPDF {
 
     void _loadInfo(const std::string& mempath);
 
+    /// Set the member path and already-loaded metadata, with version checks and banner printing
+    void _loadInfo(const std::string& mempath, const PDFInfo& info);
+
     void _loadInfo(const std::string& setname, int member) {
+      _loadInfo(_findmempath(setname, member));
+    }
+
+    void _loadInfo(int lhaid) {
+      _loadInfo(_findmempath(lhaid));
+    }
+
+    /// Find the data file path for a set name and member ID, throwing if not found
+    static std::string _findmempath(const std::string& setname, int member) {
       const string searchpath = findpdfmempath(setname, member);
       if (searchpath.empty())
         throw UserError("Can't find a valid PDF " + setname + "/" + to_str(member));
-      _loadInfo(searchpath);
+      return searchpath;
     }
 
-    void _loadInfo(int lhaid) {
+    /// Find the data file path for an LHAPDF ID, throwing if not found
+    static std::string _findmempath(int lhaid) {
       const pair<string,int> setname_memid = lookupPDF(lhaid);
       if (setname_memid.second == -1)
         throw IndexError("Can't find a PDF with LHAPDF ID = " + to_str(lhaid));
-      _loadInfo(setname_memid.first, setname_memid.second);
+      return _findmempath(setname_memid.first, setname_memid.second);
     }
 
     ///@}
@@ -75,6 +88,30 @@ namespace LHAPDF {
     /// @name PDF values
     ///@{
 
+    /// @brief Load any deferred data now, rather than on first use
+    ///
+    /// A no-op for PDF types that load all their data at construction.
+    virtual void preload() const { }
+
+    /// @brief Compute all lazily-derived state now, for lock-free concurrent queries
+    ///
+    /// Loads any deferred data, and fills the cached flavor list and
+    /// positivity flag, the subgrid lookup and interpolator tables of grid
+    /// PDFs, and the alpha_s tabulation. A frozen PDF can be queried from any
+    /// number of threads at once: xfxQ/xfxQ2 (all forms), alphasQ/alphasQ2,
+    /// the inRange* checks, flavors and hasFlavor then take no locks and make
+    /// no writes except to per-thread caches. Metadata lookups via info()
+    /// remain thread-safe, but are guarded by a lock.
+    ///
+    /// Replacing the AlphaS, interpolator, extrapolator or grids of a frozen
+    /// PDF throws a LogicError. Changes through the non-const info() and
+    /// alphaS() accessors are not checked, and must not race with queries.
+    virtual void freeze();
+
+    /// Whether freeze has been called on this PDF
+    bool frozen() const { return _frozen; }
+
+
     /// @brief Get the PDF xf(x) value at (x,q2) for the given PID.
     ///
     /// All grids are defined in Q2 rather than Q since the natural value
@@ -102,6 +139,32 @@ namespace LHAPDF {
     }
 
 
+    /// @brief Get the PDF xf(x) values at (x,q2) for several PIDs at once.
+    ///
+    /// Equivalent to out[i] = xfxQ2(ids[i], x, q2) for each i < nids, but with
+    /// the range checks done once, and for grid PDFs the subgrid, knot
+    /// indices and interpolation weights computed once for all flavors.
+    ///
+    /// @param x Momentum fraction
+    /// @param q2 Squared energy (renormalization) scale
+    /// @param ids Array of nids PDG parton IDs
+    /// @param out Array of nids PDF xf(x,q2) values, to be filled
+    /// @param nids Number of parton IDs
+    void xfxQ2(double x, double q2, const int* ids, double* out, size_t nids) const;
+
+    /// @brief Get the PDF xf(x) value at (x,q2) for "standard" PIDs.
+    ///
+    /// This version fills a user-supplied array of (at least) 13 entries,
+    /// following the LHAPDF5 convention of PDF ID order [-6, -5, ..., -1, 21,
+    /// 1, ... 5, 6], i.e. quark PDF values will be at index pid+6 and the gluon
+    /// at index 6. No containers are constructed.
+    ///
+    /// @param x Momentum fraction
+    /// @param q2 Squared energy (renormalization) scale
+    /// @param rtn Array of 13 PDF xf(x,q2) values, to be filled
+    void xfxQ2(double x, double q2, double* rtn) const;
+
+
     /// @brief Get the PDF xf(x) value at (x,q2) for all supported PIDs.
     ///
     /// This version fills a user-supplied map to avoid container construction
@@ -184,6 +247,55 @@ namespace LHAPDF {
     }
 
 
+    /// @brief Get the PDF xf(x) values at a batch of (x,q2) points for the given PID.
+    ///
+    /// Equivalent to out[i] = xfxQ2(id, xs[i], q2s[i]) for each i < n, but with
+    /// the dispatch and checks done once per batch, and for grid PDFs the
+    /// interpolation vectorised across points. If any point is unphysical, a
+    /// RangeError is thrown before any output is written.
+    ///
+    /// @param id PDG parton ID
+    /// @param xs Array of n momentum fractions
+    /// @param q2s Array of n squared energy (renormalization) scales
+    /// @param out Array of n PDF xf(x,q2) values, to be filled
+    /// @param n Number of points
+    void xfxQ2(int id, const double* xs, const double* q2s, double* out, size_t n) const;
+
+    /// @brief Get the PDF xf(x) values at a batch of (x,q2) points for the given PID.
+    ///
+    /// This version fills a user-supplied vector, resized to match the input vectors,
+    /// which must be of equal length.
+    ///
+    /// @param id PDG parton ID
+    /// @param xs Vector of momentum fractions
+    /// @param q2s Vector of squared energy (renormalization) scales
+    /// @param rtn Vector of PDF xf(x,q2) values, to be filled
+    void xfxQ2(int id, const std::vector<double>& xs, const std::vector<double>& q2s, std::vector<double>& rtn) const;
+
+
+    /// @brief Tabulate the PDF xf(x) values for all combinations of the given PIDs, x and Q values.
+    ///
+    /// Equivalent to filling out[(i*nx + j)*nq + k] = xfxQ(ids[i], xs[j], qs[k])
+    /// for all i, j and k, i.e. a contiguous table in [flavor][x][Q] order, as
+    /// needed for the fixed interpolation nodes of grid-based cross-section
+    /// codes. For grid PDFs the interpolation is separable: the x and Q2 knot
+    /// weights are computed once per node, and each Q2 knot row is interpolated
+    /// to each Q node once, then reused for every x node. The results agree with
+    /// xfxQ up to rounding. If any node is unphysical, a RangeError is thrown
+    /// before any output is written.
+    ///
+    /// @param xs Vector of momentum fraction nodes
+    /// @param qs Vector of energy (renormalization) scale nodes
+    /// @param ids Vector of PDG parton IDs
+    /// @param out Array of ids.size() * xs.size() * qs.size() PDF xf(x,q) values, to be filled
+    void tabulate(const std::vector<double>& xs, const std::vector<double>& qs, const std::vector<int>& ids, double* out) const;
+
+    /// @brief Tabulate the PDF xf(x) values for all combinations of the given PIDs, x and Q values.
+    ///
+    /// This version fills a user-supplied vector, resized to match, in [flavor][x][Q] order.
+    void tabulate(const std::vector<double>& xs, const std::vector<double>& qs, const std::vector<int>& ids, std::vector<double>& rtn) const;
+
+
   protected:
 
     /// @brief Calculate the PDF xf(x) value at (x,q2) for the given PID.
@@ -200,6 +312,34 @@ namespace LHAPDF {
     /// @return the value of xf(x,q2)
     virtual double _xfxQ2(int id, double x, double q2) const = 0;
 
+    /// @brief Calculate the PDF xf(x) values at a batch of (x,q2) points for the given PID.
+    ///
+    /// The points have already passed the physical range checks, and the PID
+    /// is defined in this PDF. The default implementation loops over the
+    /// single-point _xfxQ2: override it in PDF types which can do better in bulk.
+    virtual void _xfxQ2(int id, const double* xs, const double* q2s, double* out, size_t n) const;
+
+    /// @brief Calculate the PDF xf(x) values at (x,q2) for several PIDs.
+    ///
+    /// The point has already passed the physical range checks, and PID 0 has
+    /// been mapped to 21, but the PIDs may be undefined in this PDF: their
+    /// values must be set to zero. The default implementation loops over the
+    /// single-flavor _xfxQ2: override it in PDF types which can share work between flavors.
+    virtual void _xfxQ2(double x, double q2, const int* ids, double* out, size_t nids) const;
+
+    /// @brief Calculate the PDF xf(x) values for all combinations of the given PIDs, x and Q2 values.
+    ///
+    /// The nodes have already passed the physical range checks, and PID 0 has
+    /// been mapped to 21, but the PIDs may be undefined in this PDF: their
+    /// values must be set to zero. The output is in [flavor][x][Q2] order. The
+    /// default implementation loops over the nodes with the multi-flavor _xfxQ2:
+    /// override it in PDF types which can share work between nodes.
+    virtual void _tabulate(const std::vector<double>& xs, const std::vector<double>& q2s,
+                           const int* ids, size_t nids, double* out) const;
+
+    /// Apply the positivity forcing policy to the xf values for several PIDs
+    void _forcePositive(const int* ids, double* xfs, size_t n) const;
+
     ///@}
 
 
@@ -402,6 +542,11 @@ namespace LHAPDF {
       if (_flavors.empty()) {
         _flavors = info().get_entry_as< vector<int> >("Flavors");
         sort(_flavors.begin(), _flavors.end());
+        _flavormask = 0;
+        for (int id : _flavors) {
+          const int slot = pidSlot(id);
+          if (slot >= 0) _flavormask |= 1u << slot;
+        }
       }
       return _flavors;
     }
@@ -443,6 +588,10 @@ namespace LHAPDF {
     /// and ownership passes to this GridPDF: delete will be called on this ptr
     /// when this PDF goes out of scope or another setAlphaS call is made.
     void setAlphaS(AlphaS* alphas) {
+      if (frozen()) {
+        delete alphas; //< ownership was passed to this PDF
+        throw LogicError("Can't change the AlphaS of a frozen PDF");
+      }
       // _alphas.reset(alphas);
       if (hasAlphaS()) delete _alphas;
       _alphas = alphas;
@@ -505,6 +654,9 @@ namespace LHAPDF {
     /// Locally cached list of supported PIDs
     mutable vector<int> _flavors;
 
+    /// Bit mask of the standard PIDs in _flavors, by pidSlot()
+    mutable unsigned int _flavormask = 0;
+
     /// Optionally loaded AlphaS object
     mutable AlphaSPtr _alphas;
 
@@ -515,6 +667,9 @@ namespace LHAPDF {
     /// not), 2 = force positive definite (i.e. no values less than 1e-10).
     mutable int _forcePos;
 
+    /// Whether all derived state has been computed, and further changes are forbidden
+    bool _frozen = false;
+
   };
 
 
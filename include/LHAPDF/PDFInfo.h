@@ -10,6 +10,7 @@
 #include "LHAPDF/Info.h"
 #include "LHAPDF/Factories.h"
 #include "LHAPDF/PDFIndex.h"
+#include <atomic>
 
 namespace LHAPDF {
 
@@ -23,7 +24,7 @@ namespace LHAPDF {
     /// @note Don't use explicitly!
     ///
     /// @todo Remove?
-    PDFInfo() { }
+    PDFInfo() : _set(nullptr) { }
 
     /// Constructor from a PDF member's data path.
     ///
@@ -31,12 +32,33 @@ namespace LHAPDF {
     /// GridPDF constructor, for example.
     PDFInfo(const std::string& mempath);
 
+    /// @brief Constructor from the metadata header at the start of an open PDF member data stream
+    ///
+    /// The stream is left positioned after the header, at the start of the
+    /// data blocks. The member's data path @a mempath identifies the set and member.
+    PDFInfo(std::istream& stream, const std::string& mempath);
+
     /// Constructor from a set name and member ID.
     PDFInfo(const std::string& setname, int member);
 
     /// Constructor from an LHAPDF ID code.
     PDFInfo(int lhaid);
 
+    /// Copy constructor
+    PDFInfo(const PDFInfo& other)
+      : Info(other), _setname(other._setname), _member(other._member),
+        _set(other._set.load(std::memory_order_acquire))
+    {  }
+
+    /// Copy assignment
+    PDFInfo& operator = (const PDFInfo& other) {
+      Info::operator = (other);
+      _setname = other._setname;
+      _member = other._member;
+      _set.store(other._set.load(std::memory_order_acquire), std::memory_order_release);
+      return *this;
+    }
+
 
     /// @name Metadata accessors
     ///@{
@@ -57,6 +79,13 @@ namespace LHAPDF {
 
   private:
 
+    /// Extract the set name and member ID from a member data path
+    void _setSetMember(const std::string& mempath);
+
+    /// Get the containing PDFSet, looking it up only on first use
+    const PDFSet& _pdfset() const;
+
+
     /// Name of the set in which this PDF is contained (for PDFSet lookup)
     std::string _setname;
 
@@ -64,6 +93,9 @@ namespace LHAPDF {
     /// @note Not currently used, but could be useful if a memberID method is exposed.
     int _member;
 
+    /// Memoised containing set, to avoid a locked getPDFSet lookup per fallback query
+    mutable std::atomic<const PDFSet*> _set;
+
   };
 
 
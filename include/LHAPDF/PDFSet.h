@@ -126,6 +126,17 @@ namespace LHAPDF {
     /// This version may be preferred in many circumstances, since it can avoid
     /// the overhead of creating a new temporary vector.
     ///
+    /// The members are loaded concurrently if the LoadThreads config/set
+    /// metadata entry is greater than 1 (or 0, meaning one thread per core),
+    /// and are returned in member order in either case.
+    ///
+    /// In an MPI build this is a collective operation: rank 0 reads and parses
+    /// all the members, and broadcasts their binary grid images to all ranks
+    /// in a few large messages. If the MPISharedGrids config option is set,
+    /// the ranks on each node share one copy of the images in an MPI
+    /// shared-memory window, which is only freed by MPI_Finalize: the PDFs
+    /// must not be used after that.
+    ///
     /// A vector of *smart* pointers can be used, for any smart pointer type which
     /// supports construction from a raw pointer argument, e.g. unique_ptr<PDF>(PDF*).
     ///
@@ -154,9 +165,16 @@ namespace LHAPDF {
       pdfs.clear();
       pdfs.reserve(size());
       if (v < 2) setVerbosity(0); //< Disable every-member printout unless verbosity level is high
-      for (size_t i = 0; i < size(); ++i) {
+      std::vector<PDF*> rawpdfs;
+      try {
+        _mkPDFs(rawpdfs);
+      } catch (...) {
+        setVerbosity(v);
+        throw;
+      }
+      for (PDF* pdf : rawpdfs) {
         /// @todo Need to use an std::move here, or write differently, for unique_ptr to work?
-        pdfs.push_back( PTR(mkPDF(i)) );
+        pdfs.push_back( PTR(pdf) );
       }
       setVerbosity(v);
     }
@@ -184,6 +202,31 @@ namespace LHAPDF {
     ///@}
 
 
+    /// @name Tabulating PDF members
+    ///@{
+
+    /// @brief Tabulate the given members for all combinations of the given PIDs, x and Q values
+    ///
+    /// The @a out array must have room for pdfs.size() * ids.size() * xs.size()
+    /// * qs.size() entries, and is filled in [member][flavor][x][Q] order, with
+    /// each member's block as from PDF::tabulate.
+    static void tabulate(const std::vector<PDF*>& pdfs, const std::vector<double>& xs,
+                         const std::vector<double>& qs, const std::vector<int>& ids, double* out);
+
+    /// Tabulate the given members, filling a vector resized to match in [member][flavor][x][Q] order
+    static void tabulate(const std::vector<PDF*>& pdfs, const std::vector<double>& xs,
+                         const std::vector<double>& qs, const std::vector<int>& ids, std::vector<double>& rtn);
+
+    /// @brief Tabulate all the members of this set, filling a vector in [member][flavor][x][Q] order
+    ///
+    /// The members are made with mkPDFs and deleted afterwards: to tabulate
+    /// the same set repeatedly, make the members once and use the static version.
+    void tabulate(const std::vector<double>& xs, const std::vector<double>& qs,
+                  const std::vector<int>& ids, std::vector<double>& rtn) const;
+
+    ///@}
+
+
     /// @todo Add AlphaS getter for set-level alphaS?
 
 
@@ -307,6 +350,11 @@ namespace LHAPDF {
 
   private:
 
+    /// @brief Make all the PDFs in this set, in member order, using LoadThreads threads
+    ///
+    /// If any member fails to load, those already made are deleted and the first error rethrown.
+    void _mkPDFs(std::vector<PDF*>& pdfs) const;
+
     /// Name of this set
     std::string _setname;
 
@@ -0,0 +1,129 @@
+// -*- C++ -*-
+//
+// This file is part of LHAPDF
+// Copyright (C) 2012-2019 The LHAPDF collaboration (see AUTHORS for details)
+//
+#pragma once
+#ifndef LHAPDF_PDFSetEvaluator_H
+#define LHAPDF_PDFSetEvaluator_H
+
+#include "LHAPDF/PDFSet.h"
+#include "LHAPDF/GridPDF.h"
+
+namespace LHAPDF {
+
+
+  /// @brief Simultaneous evaluation of all members of a PDF set at the same (x,Q2)
+  ///
+  /// Uncertainty-band and reweighting calculations query every member of a set
+  /// at the same point. Rather than repeating the range checks, subgrid and
+  /// knot-index lookups, logs and interpolation weights for each member, this
+  /// class loads all members into one [member][flavor][ix][iQ2] tensor per
+  /// subgrid, computes the stencil once per point, and applies it to all members
+  /// and flavors. The member GridPDFs are re-pointed to view their slices of the
+  /// tensor, so no grid data is duplicated, and remain accessible via member().
+  ///
+  /// The fast path requires all members to share their knot geometry and
+  /// flavor content, and to use the plain log-bicubic interpolator ("logcubic",
+  /// not a derived type such as "logcubiccoeffs"): otherwise, and
+  /// for points outside the grid range, the members are evaluated one by one.
+  /// In all cases the results are identical to those of the members' own xfxQ2.
+  class PDFSetEvaluator {
+  public:
+
+    /// Constructor from a set name
+    PDFSetEvaluator(const std::string& setname);
+
+    /// Constructor from a PDF set metadata object
+    PDFSetEvaluator(const PDFSet& set);
+
+    /// Destructor
+    ~PDFSetEvaluator();
+
+    /// Copying is disabled, since the member PDFs are owned
+    PDFSetEvaluator(const PDFSetEvaluator&) = delete;
+    /// Assignment is disabled, since the member PDFs are owned
+    PDFSetEvaluator& operator = (const PDFSetEvaluator&) = delete;
+
+
+    /// @name Set content
+    ///@{
+
+    /// Number of members
+    size_t size() const { return _members.size(); }
+
+    /// Sorted list of flavors, defining the flavor index in the result blocks
+    const std::vector<int>& flavors() const { return _flavors; }
+
+    /// Access a member PDF
+    const PDF& member(size_t imem) const { return *_members[imem]; }
+
+    /// Is the shared-stencil fast path available for this set?
+    bool shared() const { return !_tensors.empty(); }
+
+    ///@}
+
+
+    /// @name Evaluation
+    ///@{
+
+    /// @brief Get xf(x,Q2) for all members and flavors
+    ///
+    /// The @a rtn array must have room for size() * flavors().size() entries,
+    /// and is filled in [member][flavor] order.
+    void xfxQ2(double x, double q2, double* rtn) const;
+
+    /// @brief Get xf(x,Q2) for all members and flavors, filling a vector
+    ///
+    /// The vector is resized to size() * flavors().size() and filled in [member][flavor] order.
+    void xfxQ2(double x, double q2, std::vector<double>& rtn) const;
+
+    /// Get xf(x,Q) for all members and flavors, filling a vector in [member][flavor] order
+    void xfxQ(double x, double q, std::vector<double>& rtn) const {
+      xfxQ2(x, q*q, rtn);
+    }
+
+    /// @brief Get xf(x,Q2) of one flavor for all members
+    ///
+    /// The vector is resized to size() and filled in member order.
+    void xfxQ2(int id, double x, double q2, std::vector<double>& rtn) const;
+
+    /// Get xf(x,Q) of one flavor for all members, filling a vector in member order
+    void xfxQ(int id, double x, double q, std::vector<double>& rtn) const {
+      xfxQ2(id, x, q*q, rtn);
+    }
+
+    ///@}
+
+
+  private:
+
+    /// Load the members and, if possible, repack them into the shared tensors
+    void _init(const PDFSet& set);
+
+    /// Evaluate flavor indices [ifl, ifl+nfl) for all members via the shared tensors
+    bool _xfxQ2Shared(double x, double q2, size_t ifl, size_t nfl, double* rtn, size_t mstride) const;
+
+    /// Member PDFs, owned by this object
+    std::vector<PDF*> _members;
+
+    /// Sorted flavor list
+    std::vector<int> _flavors;
+
+    /// Per-member positivity-forcing flags
+    std::vector<int> _forcePos;
+
+    /// Tensor of all member xf values for one subgrid
+    struct SubgridTensor {
+      std::shared_ptr<const KnotGeometry> geom;
+      std::shared_ptr< std::vector<double> > xfs;
+    };
+
+    /// Shared [member][flavor][ix][iQ2] tensors, keyed by subgrid low Q2 edge (empty if not shareable)
+    std::map<double, SubgridTensor> _tensors;
+
+  };
+
+
+}
+#endif
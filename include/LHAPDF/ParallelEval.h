@@ -0,0 +1,74 @@
+// -*- C++ -*-
+//
+// This file is part of LHAPDF
+// Copyright (C) 2012-2019 The LHAPDF collaboration (see AUTHORS for details)
+//
+#pragma once
+#ifndef LHAPDF_ParallelEval_H
+#define LHAPDF_ParallelEval_H
+
+#include "LHAPDF/PDF.h"
+#include <vector>
+
+namespace LHAPDF {
+
+
+  /// @brief One (member, flavor, x, Q2) query of a parallel batch evaluation
+  struct XQ2Query {
+    /// Index of the PDF in the list passed to xfxQ2Parallel
+    size_t member;
+    /// PDG parton ID
+    int id;
+    /// Momentum fraction
+    double x;
+    /// Squared energy (renormalization) scale
+    double q2;
+  };
+
+
+  /// @name Parallel batch evaluation
+  ///
+  /// Large batches of PDF values are split into tasks of a fixed size, which
+  /// are run on the library's persistent thread pool (see ThreadPool), so
+  /// each thread keeps its interpolation caches from one call to the next.
+  /// The PDFs are frozen (see PDF::freeze) before the evaluation starts, if
+  /// they are not already. The results do not depend on the number of
+  /// threads, and are identical to those of a call with @a nthreads = 1.
+  ///
+  /// An @a nthreads of 0 means the EvalThreads config entry, in turn with 0
+  /// meaning one thread per core. Larger counts than the number of cores are
+  /// used as given, by adding threads to the pool. If any value can't be
+  /// computed, e.g. for an unphysical x, the first error is rethrown after
+  /// the running tasks have finished, and the output is incomplete.
+  ///@{
+
+  /// @brief Evaluate an arbitrary list of queries
+  ///
+  /// Sets out[i] = pdfs[queries[i].member]->xfxQ2(queries[i].id, queries[i].x, queries[i].q2)
+  /// for each i < n. Consecutive queries of the same member and flavor are
+  /// evaluated in batches, so ordering the queries by member, flavor and
+  /// then point is the most efficient.
+  void xfxQ2Parallel(const std::vector<PDF*>& pdfs, const XQ2Query* queries, double* out, size_t n, size_t nthreads=0);
+
+  /// Evaluate an arbitrary list of queries, filling a vector resized to match
+  void xfxQ2Parallel(const std::vector<PDF*>& pdfs, const std::vector<XQ2Query>& queries,
+                     std::vector<double>& rtn, size_t nthreads=0);
+
+  /// @brief Evaluate all combinations of the given PDFs, flavors, x and Q2 values
+  ///
+  /// The @a out array must have room for pdfs.size() * ids.size() * xs.size()
+  /// * q2s.size() entries, and is filled in [member][flavor][x][Q2] order.
+  void xfxQ2Parallel(const std::vector<PDF*>& pdfs, const std::vector<int>& ids,
+                     const std::vector<double>& xs, const std::vector<double>& q2s,
+                     double* out, size_t nthreads=0);
+
+  /// Evaluate all combinations of the given PDFs, flavors, x and Q2 values, filling a vector in [member][flavor][x][Q2] order
+  void xfxQ2Parallel(const std::vector<PDF*>& pdfs, const std::vector<int>& ids,
+                     const std::vector<double>& xs, const std::vector<double>& q2s,
+                     std::vector<double>& rtn, size_t nthreads=0);
+
+  ///@}
+
+
+}
+#endif
@@ -51,8 +51,9 @@ namespace LHAPDF {
 
   /// Return the first location in which a file is found
   ///
-  /// If no matching file is found, return an empty path.
-  std::string findFile(const std::string& target);
+  /// If no matching file is found, return an empty path. As for file_exists,
+  /// @a mode 1 checks only on this MPI rank, rather than broadcasting the result from rank 0.
+  std::string findFile(const std::string& target, int mode=0);
 
   ///@}
 
@@ -66,9 +67,13 @@ namespace LHAPDF {
     return mempath;
   }
 
-  inline std::string findpdfmempath(const std::string& setname, int member) {
-    return findFile(pdfmempath(setname, member));
-  }
+  /// @brief Find the data file for the given PDF member
+  ///
+  /// If binary grids are enabled via the BinaryGrids config flag, an
+  /// up-to-date .bdat file is preferred to the ASCII .dat file. If there is
+  /// no plain .dat file, a compressed .dat.zst or .dat.gz one is used if
+  /// this build can read it. @a mode is as for findFile.
+  std::string findpdfmempath(const std::string& setname, int member, int mode=0);
 
   inline std::string pdfsetinfopath(const std::string& setname) {
     const string infoname = setname + ".info";
@@ -0,0 +1,145 @@
+// -*- C++ -*-
+//
+// This file is part of LHAPDF
+// Copyright (C) 2012-2019 The LHAPDF collaboration (see AUTHORS for details)
+//
+#pragma once
+#ifndef LHAPDF_ThreadPool_H
+#define LHAPDF_ThreadPool_H
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <atomic>
+
+namespace LHAPDF {
+
+
+  /// @brief A persistent pool of worker threads, sharing out indexed tasks by work stealing
+  ///
+  /// A call to run executes tasks 0..ntasks-1 on the calling thread and up to
+  /// nthreads-1 of the pool's workers. Each participating thread starts with
+  /// an equal contiguous range of task indices, takes tasks from the front of
+  /// its own range, and when that is exhausted steals the upper half of the
+  /// largest remaining range of another thread. Neighbouring tasks thus tend
+  /// to run on the same thread, and the workers live for the lifetime of the
+  /// pool, so per-thread state such as the interpolators' knot caches stays
+  /// warm from one task, and one run, to the next.
+  ///
+  /// Only one run is active at a time: concurrent calls from different
+  /// threads are serialised, and a run called from inside a task executes
+  /// its tasks serially on the calling thread.
+  class ThreadPool {
+  public:
+
+    /// @brief Constructor, making a pool able to run on @a nthreads threads in total (0 = one per core)
+    ///
+    /// If @a lazy is true, the pool starts with only the calling thread, and
+    /// the workers are added by the runs which need them.
+    explicit ThreadPool(size_t nthreads = 0, bool lazy = false);
+
+    /// Destructor, stopping and joining the workers
+    ~ThreadPool();
+
+    /// Copying is disabled, since the workers are owned
+    ThreadPool(const ThreadPool&) = delete;
+    /// Assignment is disabled, since the workers are owned
+    ThreadPool& operator = (const ThreadPool&) = delete;
+
+    /// Number of threads in the pool, including the calling thread of a run
+    size_t size() const { return _size; }
+
+    /// Number of threads used by a run which doesn't specify it, as given to the constructor
+    size_t defaultThreads() const { return _defaultthreads; }
+
+    /// @brief Run @a task(i) for each i in [0, ntasks), on up to @a nthreads threads (0 = the default)
+    ///
+    /// If @a nthreads is larger than the pool, and there are enough tasks,
+    /// workers are first added to the pool, which then keeps them. Returns
+    /// once all tasks have completed. If any task throws, no further tasks
+    /// are started and the first exception is rethrown here.
+    void run(size_t ntasks, const std::function<void(size_t)>& task, size_t nthreads = 0);
+
+    /// @brief The library-wide pool used for parallel evaluation
+    ///
+    /// Created lazily on first use, with only the calling thread: workers are
+    /// added as runs ask for them, up to one thread per core by default, or
+    /// more if a run asks for more. A program which never evaluates in
+    /// parallel thus never starts a worker.
+    static ThreadPool& global();
+
+
+  private:
+
+    /// Range of task indices still to be run by one thread, padded to its own cache line
+    struct alignas(64) TaskRange {
+      std::mutex mutex;
+      size_t begin = 0, end = 0;
+    };
+
+    /// Add workers up to @a nthreads threads in total, when no run is active
+    void _grow(size_t nthreads);
+
+    /// Main loop of the worker thread @a iw, started after run number @a generation
+    void _workerLoop(size_t iw, size_t generation);
+
+    /// Run tasks as participant @a ip of the current run, until none are left
+    void _work(size_t ip);
+
+    /// Move the upper half of the largest other task range to participant @a ip, returning false if all are empty
+    bool _steal(size_t ip);
+
+    /// Worker threads
+    std::vector<std::thread> _workers;
+
+    /// Number of threads, readable while the pool grows
+    std::atomic<size_t> _size{1};
+
+    /// Number of threads for a run which doesn't specify it
+    size_t _defaultthreads;
+
+    /// Per-participant task ranges of the current run, the caller's first
+    std::unique_ptr<TaskRange[]> _ranges;
+
+    /// Guard for running only one run at a time
+    std::mutex _runmutex;
+
+    /// Guard for the run state below, shared with the workers
+    std::mutex _mutex;
+
+    /// Signal to the workers that a run has started, or the pool is stopping
+    std::condition_variable _startcv;
+
+    /// Signal to the caller that a worker has finished its part of the run
+    std::condition_variable _donecv;
+
+    /// Count of runs started, by which the workers notice a new one
+    size_t _generation = 0;
+
+    /// Number of participants in the current run
+    size_t _nparticipants = 0;
+
+    /// Number of workers still busy with the current run
+    size_t _nbusy = 0;
+
+    /// Task of the current run
+    const std::function<void(size_t)>* _task = nullptr;
+
+    /// First exception thrown by a task of the current run
+    std::exception_ptr _error;
+
+    /// Whether a task has failed, so no more should be started
+    std::atomic<bool> _failed{false};
+
+    /// Whether the pool is being destroyed
+    bool _stopping = false;
+
+  };
+
+
+}
+#endif
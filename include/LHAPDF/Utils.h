@@ -231,6 +231,23 @@ namespace LHAPDF {
   ///@}
 
 
+  /// @name Parton ID utils
+  ///@{
+
+  /// Number of dense lookup slots for the standard parton IDs
+  const int NPIDSLOTS = 15;
+
+  /// @brief Dense slot index for the standard PDG IDs -6..6, 21 and 22, or -1 for any other ID
+  inline int pidSlot(int id) {
+    if (id >= -6 && id <= 6) return id + 6;
+    if (id == 21) return 13;
+    if (id == 22) return 14;
+    return -1;
+  }
+
+  ///@}
+
+
   /// @name Container utils
   ///@{
 
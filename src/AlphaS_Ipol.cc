@@ -55,6 +55,11 @@ namespace LHAPDF {
   }
 
 
+  void AlphaS_Ipol::freeze() {
+    if (_knotarrays.empty() && !_q2s.empty()) _setup_grids();
+  }
+
+
   double AlphaS_Ipol::_interpolateCubic(double T, double VL, double VDL, double VH, double VDH) const {
     // Pre-calculate powers of T
     const double t2 = T*T;
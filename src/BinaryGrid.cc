@@ -0,0 +1,580 @@
+// -*- C++ -*-
+//
+// This file is part of LHAPDF
+// Copyright (C) 2012-2019 The LHAPDF collaboration (see AUTHORS for details)
+//
+#include "LHAPDF/BinaryGrid.h"
+#include "LHAPDF/GridPDF.h"
+#include "LHAPDF/Config.h"
+#include <fstream>
+#include <cstring>
+#include <cstddef>
+#include <cstdio>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <climits>
+#include <cerrno>
+#include <cstdlib>
+#include <mutex>
+
+namespace LHAPDF {
+
+
+  namespace {
+
+    /// Magic string at the start of every binary grid file
+    const char MAGIC[8] = {'L','H','A','P','D','F','b','g'};
+
+    /// Byte-order mark, for detection of files written on a different architecture
+    const uint64_t BOM = 0x0102030405060708ULL;
+
+    /// Alignment of the xf value blocks
+    const size_t XFALIGN = 64;
+
+    /// Fixed-size file header
+    struct FileHeader {
+      char magic[8];
+      uint64_t version;
+      uint64_t bom;
+      uint64_t metalen;
+      uint64_t nsubgrids;
+      uint64_t reserved[3];
+    };
+
+    /// Fixed-size subgrid header
+    struct SubgridHeader {
+      uint64_t nx;
+      uint64_t nq2;
+      uint64_t nflavs;
+      uint64_t reserved;
+    };
+
+    /// Round @a n up to a multiple of @a align
+    inline size_t _aligned(size_t n, size_t align) {
+      return (n + align - 1) / align * align;
+    }
+
+    /// Check the file header, returning the offset of the first subgrid (which may be beyond @a size)
+    size_t _checkHeader(const char* data, size_t size, const std::string& path) {
+      if (size < sizeof(FileHeader))
+        throw ReadError("Binary grid file " + path + " is truncated");
+      const FileHeader& h = *reinterpret_cast<const FileHeader*>(data);
+      if (memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0)
+        throw ReadError("File " + path + " is not a binary LHAPDF grid file");
+      if (h.bom != BOM)
+        throw ReadError("Binary grid file " + path + " was written with an incompatible byte ordering");
+      if (h.version != BINARYGRID_VERSION)
+        throw ReadError("Binary grid file " + path + " has unsupported format version " + to_str(h.version));
+      return sizeof(FileHeader) + _aligned(h.metalen, 8);
+    }
+
+    /// Append @a n bytes of @a data to the output buffer
+    inline void _append(std::string& buf, const void* data, size_t n) {
+      buf.append(static_cast<const char*>(data), n);
+    }
+
+    /// Zero-pad the output buffer to a multiple of @a align bytes
+    inline void _pad(std::string& buf, size_t align) {
+      buf.append(_aligned(buf.size(), align) - buf.size(), '\0');
+    }
+
+
+    /// Register the subgrids of the binary grid image at @a data in @a arrays, viewing its xf blocks
+    void _readImage(const std::shared_ptr<const char>& data, size_t size, const std::string& path,
+                    std::map<double, KnotArrayNF>& arrays, std::string* metadata) {
+      size_t offset = _checkHeader(data.get(), size, path);
+      const FileHeader& h = *reinterpret_cast<const FileHeader*>(data.get());
+      if (h.metalen > size - sizeof(FileHeader))
+        throw ReadError("Binary grid file " + path + " is truncated");
+      if (metadata != nullptr) metadata->assign(data.get() + sizeof(FileHeader), h.metalen);
+
+      for (size_t isub = 0; isub < h.nsubgrids; ++isub) {
+        const std::string errmsg = "Binary grid file " + path + " is truncated or invalid in subgrid " + to_str(isub);
+        if (offset > size || size - offset < sizeof(SubgridHeader)) throw ReadError(errmsg);
+        const SubgridHeader& sh = *reinterpret_cast<const SubgridHeader*>(data.get() + offset);
+        offset += sizeof(SubgridHeader);
+
+        // Check each count against the remaining size before forming any pointers,
+        // dividing rather than multiplying so that corrupt counts can't overflow
+        const size_t nwords = (size - offset) / 8;
+        if (sh.nx == 0 || sh.nq2 == 0 || sh.nflavs == 0 ||
+            sh.nx > nwords || sh.nq2 > nwords - sh.nx || sh.nflavs > nwords - sh.nx - sh.nq2)
+          throw ReadError(errmsg);
+        const double* xknots = reinterpret_cast<const double*>(data.get() + offset);
+        const double* q2knots = xknots + sh.nx;
+        const int64_t* pids = reinterpret_cast<const int64_t*>(q2knots + sh.nq2);
+        offset = _aligned(offset + (sh.nx + sh.nq2 + sh.nflavs)*8, XFALIGN);
+        if (offset > size) throw ReadError(errmsg);
+        const size_t nxfs = (size - offset) / sizeof(double);
+        if (sh.nq2 > nxfs / sh.nx || sh.nflavs > nxfs / (sh.nx*sh.nq2))
+          throw ReadError(errmsg);
+        const size_t npts = sh.nx*sh.nq2;
+
+        // Register the subgrid, with each flavor viewing its block of the mapped file
+        const std::vector<double> xs(xknots, xknots + sh.nx), q2s(q2knots, q2knots + sh.nq2);
+        KnotArrayNF& arraynf = arrays[q2s.front()];
+        const std::shared_ptr<const KnotGeometry> geom = KnotGeometry::mk(xs, q2s);
+        for (size_t ipid = 0; ipid < sh.nflavs; ++ipid) {
+          const double* xfs = reinterpret_cast<const double*>(data.get() + offset) + ipid*npts;
+          arraynf[pids[ipid]] = KnotArray1F(geom);
+          arraynf[pids[ipid]].setxfs(std::shared_ptr<const double>(data, xfs));
+        }
+        offset += sh.nflavs*npts*sizeof(double);
+      }
+    }
+
+
+    /// Write @a buf to a temporary file and atomically move it into place at @a path
+    void _writeFile(const std::string& buf, const std::string& path) {
+      const std::string tmppath = path + ".tmp" + to_str(getpid());
+      {
+        std::ofstream file(tmppath.c_str(), std::ios::binary | std::ios::trunc);
+        if (!file.write(buf.data(), buf.size()))
+          throw Exception("Could not write binary grid file " + tmppath);
+      }
+      if (rename(tmppath.c_str(), path.c_str()) != 0) {
+        remove(tmppath.c_str());
+        throw Exception("Could not move binary grid file into place at " + path);
+      }
+    }
+
+
+    /// 64-bit FNV-1a-style hash of @a n bytes, mixed a word at a time, continuing from @a h
+    uint64_t _hashBytes(const char* data, size_t n, uint64_t h=14695981039346656037ULL) {
+      const uint64_t FNV_PRIME = 1099511628211ULL;
+      size_t i = 0;
+      for (; i + 8 <= n; i += 8) {
+        uint64_t w;
+        memcpy(&w, data + i, 8);
+        h = (h ^ w) * FNV_PRIME;
+        h ^= h >> 29;
+      }
+      for (; i < n; ++i) h = (h ^ static_cast<unsigned char>(data[i])) * FNV_PRIME;
+      return (h ^ n) * FNV_PRIME;
+    }
+
+    /// Hash of a string
+    uint64_t _hashString(const std::string& s) {
+      return _hashBytes(s.data(), s.size());
+    }
+
+    /// Format a hash as a fixed-width hex string
+    std::string _hexHash(uint64_t h) {
+      std::ostringstream ss;
+      ss << std::hex << std::setw(16) << std::setfill('0') << h;
+      return ss.str();
+    }
+
+
+    /// Canonical absolute path to @a path, or @a path itself if it can't be resolved
+    std::string _realPath(const std::string& path) {
+      char buf[PATH_MAX];
+      return (realpath(path.c_str(), buf) != nullptr) ? std::string(buf) : path;
+    }
+
+
+    /// Create the directory @a dir and any missing parents
+    void _makeDirs(const std::string& dir) {
+      for (size_t pos = dir.find('/', 1); ; pos = dir.find('/', pos + 1)) {
+        const std::string d = dir.substr(0, pos);
+        if (!d.empty() && mkdir(d.c_str(), 0777) != 0 && errno != EEXIST)
+          throw Exception("Could not create directory " + d);
+        if (pos == std::string::npos) break;
+      }
+    }
+
+
+    /// Memory-map the whole of the open file @a fd read-only, closing the descriptor
+    std::shared_ptr<const char> _mapFd(int fd, const std::string& path, size_t& size) {
+      struct stat st;
+      if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        throw ReadError("Could not determine size of file " + path + " for memory mapping");
+      }
+      size = st.st_size;
+      void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+      ::close(fd); //< the mapping remains valid after the descriptor is closed
+      if (addr == MAP_FAILED) throw ReadError("Could not memory-map file " + path);
+      const size_t len = size;
+      return std::shared_ptr<const char>(static_cast<const char*>(addr), [len](const char* p) { munmap(const_cast<char*>(p), len); });
+    }
+
+
+    /// Holds an exclusive lock on a lock file for the lifetime of the object
+    class FileLock {
+    public:
+      FileLock(const std::string& path) {
+        _fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0666);
+        // A lock file created by another user is read-only for us after their umask, but flock
+        // works on a read-only descriptor just as well
+        if (_fd < 0 && errno == EACCES) _fd = ::open(path.c_str(), O_RDONLY);
+        if (_fd < 0) throw Exception("Could not open lock file " + path);
+        while (flock(_fd, LOCK_EX) != 0) {
+          if (errno != EINTR) {
+            ::close(_fd);
+            throw Exception("Could not lock file " + path);
+          }
+        }
+      }
+      ~FileLock() {
+        flock(_fd, LOCK_UN);
+        ::close(_fd);
+      }
+      /// The locked file's descriptor, which may be read-only
+      int fd() const { return _fd; }
+    private:
+      FileLock(const FileLock&);
+      FileLock& operator = (const FileLock&);
+      int _fd;
+    };
+
+
+    /// Create the shared-memory segment @a name holding @a image, writing the magic string last
+    void _publishImage(const std::string& name, const std::string& image) {
+      shm_unlink(name.c_str()); //< discard any incomplete segment left by a failed publisher
+      const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+      if (fd < 0) throw Exception("Could not create shared-memory grid segment " + name);
+      void* addr = MAP_FAILED;
+      if (ftruncate(fd, image.size()) == 0)
+        addr = mmap(nullptr, image.size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      ::close(fd);
+      if (addr == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw Exception("Could not allocate shared-memory grid segment " + name);
+      }
+      char* dest = static_cast<char*>(addr);
+      memcpy(dest + sizeof(MAGIC), image.data() + sizeof(MAGIC), image.size() - sizeof(MAGIC));
+      memcpy(dest, image.data(), sizeof(MAGIC));
+      munmap(addr, image.size());
+    }
+
+
+    /// @brief Record @a name in the locked file @a fd as the current segment, unlinking the one it supersedes
+    ///
+    /// Each member file has one lock file, which names the last segment
+    /// published for it, so segments for older versions of the file do not
+    /// pile up until a reboot.
+    void _recordSegment(int fd, const std::string& name) {
+      char buf[64];
+      const ssize_t n = pread(fd, buf, sizeof(buf), 0);
+      const std::string prev(buf, (n > 0) ? n : 0);
+      if (prev != name && prev.compare(0, 8, "/lhapdf-") == 0)
+        shm_unlink(prev.c_str()); //< attached processes can continue to use it
+      // Writing fails on another user's read-only lock file, whose segments are theirs to remove anyway
+      if (ftruncate(fd, 0) == 0 && pwrite(fd, name.data(), name.size(), 0) != ssize_t(name.size()))
+        ftruncate(fd, 0); //< rather than leave a partial name
+    }
+
+  }
+
+
+
+  std::shared_ptr<const char> mapFile(const std::string& path, size_t& size) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw ReadError("Could not open file " + path + " for memory mapping");
+    return _mapFd(fd, path, size);
+  }
+
+
+  std::string readBinaryGridMetadata(const std::string& path) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    FileHeader h;
+    if (!file.read(reinterpret_cast<char*>(&h), sizeof(h)))
+      throw ReadError("Binary grid file " + path + " is truncated");
+    _checkHeader(reinterpret_cast<const char*>(&h), sizeof(h), path);
+    file.seekg(0, std::ios::end);
+    if (h.metalen > uint64_t(file.tellg()) - sizeof(h))
+      throw ReadError("Binary grid file " + path + " is truncated");
+    file.seekg(sizeof(h));
+    std::string rtn(h.metalen, '\0');
+    if (h.metalen > 0 && !file.read(&rtn[0], h.metalen))
+      throw ReadError("Binary grid file " + path + " is truncated");
+    return rtn;
+  }
+
+
+  std::string binaryGridImage(const std::map<double, KnotArrayNF>& arrays, const std::vector<int>& flavors, const std::string& metadata) {
+    // The stored flavors of each subgrid, in the set's flavor order
+    std::vector< std::vector<int64_t> > subgridpids;
+    for (const auto& q2_ka : arrays) {
+      subgridpids.push_back(std::vector<int64_t>());
+      for (int pid : flavors)
+        if (q2_ka.second.has_pid(pid)) subgridpids.back().push_back(pid);
+    }
+
+    // Reserve the whole image, with the same alignment steps as the writing below
+    size_t size = _aligned(sizeof(FileHeader) + metadata.size(), 8);
+    size_t isub = 0;
+    for (const auto& q2_ka : arrays) {
+      const KnotArray1F& grid1 = q2_ka.second.get_first();
+      const size_t nflavs = subgridpids[isub++].size();
+      size = _aligned(size + sizeof(SubgridHeader) + (grid1.xsize() + grid1.q2size() + nflavs)*8, XFALIGN);
+      size += nflavs*grid1.size()*sizeof(double);
+    }
+    std::string buf;
+    buf.reserve(size);
+
+    FileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = BINARYGRID_VERSION;
+    h.bom = BOM;
+    h.metalen = metadata.size();
+    h.nsubgrids = arrays.size();
+    _append(buf, &h, sizeof(h));
+    _append(buf, metadata.data(), metadata.size());
+    _pad(buf, 8);
+    isub = 0;
+    std::vector<double> block;
+    for (const auto& q2_ka : arrays) {
+      const KnotArrayNF& arraynf = q2_ka.second;
+      const KnotArray1F& grid1 = arraynf.get_first();
+      const std::vector<int64_t>& pids = subgridpids[isub++];
+      SubgridHeader sh;
+      sh.nx = grid1.xsize();
+      sh.nq2 = grid1.q2size();
+      sh.nflavs = pids.size();
+      sh.reserved = 0;
+      _append(buf, &sh, sizeof(sh));
+      _append(buf, grid1.xs().data(), sh.nx*sizeof(double));
+      _append(buf, grid1.q2s().data(), sh.nq2*sizeof(double));
+      _append(buf, pids.data(), pids.size()*sizeof(int64_t));
+      _pad(buf, XFALIGN);
+      for (int64_t pid : pids) {
+        const KnotArray1F& grid = arraynf.get_pid(pid);
+        if (grid.geometry() != grid1.geometry())
+          throw GridError("Can't write flavor grids with different knot arrays to a binary grid file (PID = " + to_str(pid) + ")");
+        // Append each flavor's block at once, directly from locally-owned double storage if possible
+        if (!grid.shared() && grid.precision() == KnotArray1F::DOUBLE) {
+          _append(buf, grid.xfs().data(), grid.size()*sizeof(double));
+          continue;
+        }
+        block.resize(grid.size());
+        for (size_t i = 0; i < block.size(); ++i) block[i] = grid.xf(i / sh.nq2, i % sh.nq2);
+        _append(buf, block.data(), block.size()*sizeof(double));
+      }
+    }
+    assert(buf.size() == size);
+    return buf;
+  }
+
+
+  void writeBinaryGrid(const GridPDF& pdf, const std::string& metadata, const std::string& path) {
+    _writeFile(binaryGridImage(pdf.knotarrays(), pdf.flavors(), metadata), path);
+  }
+
+
+  void convertToBinaryGrid(const std::string& datpath, const std::string& binpath) {
+    // Read the metadata header text, up to the first document separator
+    std::ifstream file(datpath.c_str());
+    if (!file) throw ReadError("Could not open PDF data file " + datpath);
+    std::string metadata, line;
+    while (std::getline(file, line)) {
+      if (line == "---") break;
+      metadata += line + "\n";
+    }
+    file.close();
+    // Load the grids and write them out in binary form
+    const GridPDF pdf(datpath);
+    writeBinaryGrid(pdf, metadata, binpath.empty() ? binaryGridPath(datpath) : binpath);
+  }
+
+
+  void readBinaryGrid(const std::string& path, std::map<double, KnotArrayNF>& arrays, std::string* metadata) {
+    size_t size = 0;
+    const std::shared_ptr<const char> data = mapFile(path, size);
+    _readImage(data, size, path, arrays, metadata);
+  }
+
+
+  void readGridImage(const std::shared_ptr<const char>& data, size_t size, const std::string& name,
+                     std::map<double, KnotArrayNF>& arrays, std::string* metadata) {
+    _readImage(data, size, name, arrays, metadata);
+  }
+
+
+
+  namespace {
+
+    /// Registered grid images, by member file path
+    struct GridImageRegistry {
+      std::mutex mutex;
+      std::map< std::string, std::pair<std::shared_ptr<const char>, size_t> > images;
+    };
+
+    GridImageRegistry& _gridImages() {
+      static GridImageRegistry registry;
+      return registry;
+    }
+
+  }
+
+
+  void registerGridImage(const std::string& mempath, const std::shared_ptr<const char>& data, size_t size) {
+    GridImageRegistry& reg = _gridImages();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.images[mempath] = std::make_pair(data, size);
+  }
+
+
+  std::shared_ptr<const char> takeGridImage(const std::string& mempath, size_t& size) {
+    GridImageRegistry& reg = _gridImages();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    auto it = reg.images.find(mempath);
+    if (it == reg.images.end()) return nullptr;
+    const std::shared_ptr<const char> data = it->second.first;
+    size = it->second.second;
+    reg.images.erase(it);
+    return data;
+  }
+
+
+  void clearGridImages() {
+    GridImageRegistry& reg = _gridImages();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.images.clear();
+  }
+
+
+
+  std::string sharedGridName(const std::string& mempath) {
+    const std::string path = _realPath(mempath);
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+      throw ReadError("Could not find PDF data file " + path + " for sharing");
+    // Hash the file identity and the image format version
+    const std::string key = path + ":" + to_str(st.st_size) + ":" + to_str(st.st_mtime) + ":" + to_str(BINARYGRID_VERSION);
+    return "/lhapdf-" + _hexHash(_hashString(key));
+  }
+
+
+  void readSharedGrid(const std::string& mempath, std::map<double, KnotArrayNF>& arrays, std::string* metadata,
+                      const std::function<std::string()>& mkimage) {
+    const std::string name = sharedGridName(mempath);
+    // The lock file is named from the path alone, and shared by all versions of the file
+    const char* tmpdir = getenv("TMPDIR");
+    const std::string lockpath = std::string((tmpdir != nullptr && *tmpdir != '\0') ? tmpdir : "/tmp") +
+      "/lhapdf-" + _hexHash(_hashString(_realPath(mempath))) + ".lock";
+    std::shared_ptr<const char> data;
+    size_t size = 0;
+    {
+      // Attach to a complete existing image, or else publish one, while holding the lock
+      FileLock lock(lockpath);
+      const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+      if (fd >= 0) {
+        try {
+          data = _mapFd(fd, name, size);
+          _checkHeader(data.get(), size, name);
+        } catch (const ReadError&) {
+          data.reset(); //< incomplete, e.g. from a crashed publisher: replace it
+        }
+      }
+      if (!data) {
+        _publishImage(name, mkimage());
+        _recordSegment(lock.fd(), name);
+        const int fd2 = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd2 < 0) throw ReadError("Could not open shared-memory grid segment " + name);
+        data = _mapFd(fd2, name, size);
+      }
+    }
+    arrays.clear();
+    _readImage(data, size, name, arrays, metadata);
+  }
+
+
+  bool removeSharedGrid(const std::string& mempath) {
+    return shm_unlink(sharedGridName(mempath).c_str()) == 0;
+  }
+
+
+
+  std::string gridCacheDir() {
+    const char* env = getenv("LHAPDF_GRID_CACHE");
+    if (env != nullptr) return env;
+    return getConfig().get_entry("GridCacheDir", "");
+  }
+
+
+  std::string gridCachePath(const std::string& mempath) {
+    const std::string dir = gridCacheDir();
+    if (dir.empty()) return "";
+    return dir / (file_stem(basename(uncompressedPath(mempath))) + "-" + _hexHash(_hashString(_realPath(mempath))) + "." + BINARYGRID_EXTN);
+  }
+
+
+  void readCachedGrid(const std::string& mempath, std::map<double, KnotArrayNF>& arrays, std::string* metadata,
+                      const std::function<std::string()>& mkimage) {
+    const std::string cachepath = gridCachePath(mempath);
+    if (cachepath.empty()) throw UserError("No grid cache directory is set");
+
+    // Identify the source file by its path, size and modification time
+    const std::string path = _realPath(mempath);
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+      throw ReadError("Could not find PDF data file " + path + " for caching");
+    const uint64_t key = _hashString(path + ":" + to_str(st.st_size) + ":" + to_str(st.st_mtime));
+    const bool verify = getConfig().get_entry_as<bool>("GridCacheVerify", false);
+
+    // The source contents are only hashed if the entry's key doesn't match, or if verification is requested
+    uint64_t srchash = 0;
+    bool srchashed = false;
+    auto hashSource = [&]() {
+      if (srchashed) return srchash;
+      size_t srcsize = 0;
+      const std::shared_ptr<const char> src = mapFile(path, srcsize);
+      srchash = _hashBytes(src.get(), srcsize);
+      srchashed = true;
+      return srchash;
+    };
+
+    // Use the cache entry if it matches the source
+    if (file_exists(cachepath)) {
+      try {
+        size_t size = 0;
+        const std::shared_ptr<const char> data = mapFile(cachepath, size);
+        _checkHeader(data.get(), size, cachepath);
+        const FileHeader& h = *reinterpret_cast<const FileHeader*>(data.get());
+        bool valid = (h.reserved[0] == key);
+        if (!valid || verify) {
+          // An unchanged source with a new mtime, e.g. from a copy, keeps its entry if the contents are intact,
+          // and the entry is restamped with the new key
+          valid = (h.reserved[1] == hashSource() &&
+                   h.reserved[2] == _hashBytes(data.get() + sizeof(FileHeader), size - sizeof(FileHeader)));
+          if (valid && h.reserved[0] != key) {
+            std::fstream file(cachepath.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(offsetof(FileHeader, reserved));
+            file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+          }
+        }
+        if (valid) {
+          std::map<double, KnotArrayNF> cached;
+          _readImage(data, size, cachepath, cached, metadata);
+          arrays.swap(cached);
+          return;
+        }
+      } catch (const ReadError&) {
+        // Corrupt entry: fall through to rebuild it
+      }
+    }
+
+    // Otherwise build the image, stamped with the source key, the source and image checksums, and save it for next time
+    std::shared_ptr<std::string> image = std::make_shared<std::string>(mkimage());
+    FileHeader& h = *reinterpret_cast<FileHeader*>(&(*image)[0]);
+    h.reserved[0] = key;
+    h.reserved[1] = hashSource();
+    h.reserved[2] = _hashBytes(image->data() + sizeof(FileHeader), image->size() - sizeof(FileHeader));
+    try {
+      _makeDirs(dirname(cachepath));
+      _writeFile(*image, cachepath);
+    } catch (const Exception& e) {
+      if (verbosity() > 0) std::cerr << "WARNING: Could not write grid cache entry: " << e.what() << std::endl;
+    }
+    arrays.clear();
+    _readImage(std::shared_ptr<const char>(image, image->data()), image->size(), cachepath, arrays, metadata);
+  }
+
+
+}
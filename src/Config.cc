@@ -5,6 +5,7 @@
 //
 #include "LHAPDF/Config.h"
 #include "LHAPDF/Version.h"
+#include <mutex>
 using namespace std;
 
 namespace LHAPDF {
@@ -12,11 +13,12 @@ namespace LHAPDF {
 
   Config& Config::get() {
     static Config _cfg; //< Could we use the Info(path) constructor for automatic init-once behaviour?
-    // Test for emptiness and only initialise *once*:
-    if (_cfg._metadict.empty()) {
-      std::string confpath = findFile("lhapdf.conf");
-      if (!confpath.empty()) _cfg.load(confpath);
-    }
+    // Only initialise *once*, even if first used from several threads at the same time:
+    static once_flag _cfginit;
+    call_once(_cfginit, []() {
+        std::string confpath = findFile("lhapdf.conf");
+        if (!confpath.empty()) _cfg.load(confpath);
+      });
     return _cfg;
   }
 
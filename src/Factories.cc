@@ -13,10 +13,12 @@
 #include "LHAPDF/BicubicInterpolator.h"
 #include "LHAPDF/LogBilinearInterpolator.h"
 #include "LHAPDF/LogBicubicInterpolator.h"
+#include "LHAPDF/LogBicubicCoeffInterpolator.h"
 #include "LHAPDF/ErrExtrapolator.h"
 #include "LHAPDF/NearestPointExtrapolator.h"
 #include "LHAPDF/ContinuationExtrapolator.h"
 #include "LHAPDF/AlphaS.h"
+#include <mutex>
 
 namespace LHAPDF {
 
@@ -28,6 +30,8 @@ namespace LHAPDF {
 
   PDFSet& getPDFSet(const string& setname) {
     static map<string, PDFSet> _sets;
+    static mutex _setsmutex; //< map elements are never removed, so returned references stay valid after unlocking
+    lock_guard<mutex> lock(_setsmutex);
     map<string, PDFSet>::iterator it = _sets.find(setname);
     if (it != _sets.end()) return it->second;
     _sets[setname] = PDFSet(setname);
@@ -55,11 +59,11 @@ namespace LHAPDF {
         throw UserError("PDF " + setname + "/" + to_str(member) + " is out of the member range of set " + setname);
       throw UserError("Can't find a valid PDF " + setname + "/" + to_str(member));
     }
-    // First create an Info object to work out what format of PDF this is:
-    Info info(searchpath);
-    const string fmt = info.get_entry("Format");
+    // Work out what format of PDF this is from the (cached) set-level metadata, rather
+    // than by an extra read of the member file: the member's own format is checked on loading
+    const string fmt = getPDFSet(setname).get_entry("Format", "lhagrid1");
     // Then use the format information to call the appropriate concrete PDF constructor:
-    if (fmt == "lhagrid1") return new GridPDF(setname, member);
+    if (fmt == "lhagrid1") return new GridPDF(searchpath);
     /// @todo Throw a deprecation error if format version is too old or new
     throw FactoryError("No LHAPDF factory defined for format type '" + fmt + "'");
   }
@@ -98,6 +102,8 @@ namespace LHAPDF {
       return new LogBilinearInterpolator();
     else if (iname == "logcubic")
       return new LogBicubicInterpolator();
+    else if (iname == "logcubiccoeffs")
+      return new LogBicubicCoeffInterpolator();
     else
       throw FactoryError("Undeclared interpolator requested: " + name);
   }
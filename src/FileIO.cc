@@ -4,23 +4,280 @@
 // Copyright (C) 2012-2019 The LHAPDF collaboration (see AUTHORS for details)
 //
 #include "LHAPDF/FileIO.h"
+#include "LHAPDF/Exceptions.h"
 
 #include <typeinfo>
 #include <cstdlib>
 #include <cstring>
 #include <algorithm>
 #include <map>
+#include <list>
+#include <limits>
+#include <mutex>
 
 #include <sys/stat.h>
 #ifdef HAVE_MPI
 #include <mpi.h>
 #endif
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
 
 namespace LHAPDF {
 
 
-  typedef std::map<std::string,std::string> FileContentMap;
-  static FileContentMap lhapdf_filecontents;
+  namespace {
+
+
+    /// @brief Byte-budgeted cache of file contents, shared between readers
+    ///
+    /// Only used with MPI, to broadcast each file once. The MPI protocol
+    /// relies on all ranks making the same sequence of cache lookups, so entries
+    /// are evicted oldest first: the cache state then only depends on the
+    /// sequence of broadcasts, which is the same on all ranks, and not on how
+    /// often each rank has looked up each file.
+    class FileContentCache {
+    public:
+
+      /// Get the cached content of file @a name, or null if not cached
+      std::shared_ptr<const std::string> get(const std::string& name) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::map<std::string, Entry>::iterator it = _entries.find(name);
+        if (it == _entries.end()) return nullptr;
+        return it->second.content;
+      }
+
+      /// Add the content of file @a name, evicting the oldest entries as needed
+      void put(const std::string& name, const std::shared_ptr<const std::string>& content) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _erase(name);
+        if (content->size() > _budget) return;
+        _order.push_front(name);
+        Entry& entry = _entries[name];
+        entry.content = content;
+        entry.pos = _order.begin();
+        _bytes += content->size();
+        _evict();
+      }
+
+      void clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _entries.clear();
+        _order.clear();
+        _bytes = 0;
+      }
+
+      void setBudget(size_t bytes) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _budget = bytes;
+        _evict();
+      }
+
+    private:
+
+      struct Entry {
+        std::shared_ptr<const std::string> content;
+        std::list<std::string>::iterator pos;
+      };
+
+      void _erase(const std::string& name) {
+        std::map<std::string, Entry>::iterator it = _entries.find(name);
+        if (it == _entries.end()) return;
+        _bytes -= it->second.content->size();
+        _order.erase(it->second.pos);
+        _entries.erase(it);
+      }
+
+      void _evict() {
+        while (_bytes > _budget && !_order.empty()) _erase(_order.back());
+      }
+
+      std::mutex _mutex;
+      std::map<std::string, Entry> _entries;
+      std::list<std::string> _order; //< names, most recently added first
+      size_t _bytes = 0;
+      size_t _budget = std::numeric_limits<size_t>::max();
+
+    };
+
+
+    FileContentCache& fileContentCache() {
+      static FileContentCache cache;
+      return cache;
+    }
+
+
+    /// Read the whole file @a name into @a content, returning false if it can't be opened
+    bool readFileContent(const std::string& name, std::string& content) {
+      std::ifstream infile(name.c_str(), std::ios::binary);
+      if (!infile.good()) return false;
+      infile.seekg(0, std::ios::end);
+      const std::streamoff size = infile.tellg();
+      if (size >= 0) {
+        content.resize(size);
+        infile.seekg(0, std::ios::beg);
+        infile.read(&content[0], size);
+        content.resize(infile.gcount());
+      } else { //< not seekable
+        infile.clear();
+        std::ostringstream ss;
+        ss << infile.rdbuf();
+        content = ss.str();
+      }
+      return true;
+    }
+
+
+    /// @brief Input stream buffer which decompresses the contents of another buffer as it is read
+    ///
+    /// The codec is chosen by the file extension of @a name, which is also used
+    /// in error messages. Concatenated gzip members and zstd frames are read as
+    /// one stream. Corrupt or truncated data throws a ReadError, which the
+    /// reading istream turns into its badbit.
+    class DecompressBuf : public std::streambuf {
+    public:
+
+      DecompressBuf(std::streambuf* src, const std::string& name)
+        : _src(src), _name(name), _in(CHUNKSIZE), _out(CHUNKSIZE), _inpos(0), _inlen(0), _ended(false)
+      {
+        const std::string extn = name.substr(name.rfind('.')+1);
+        #ifdef HAVE_ZLIB
+        if (extn == "gz") {
+          _zlib = true;
+          std::memset(&_zs, 0, sizeof(_zs));
+          if (inflateInit2(&_zs, 15+32) != Z_OK) //< 15+32: maximum window, and gzip or zlib header detection
+            throw ReadError("Could not initialise zlib decompression for " + name);
+          return;
+        }
+        #endif
+        #ifdef HAVE_ZSTD
+        if (extn == "zst") {
+          _zds = ZSTD_createDStream();
+          if (_zds == nullptr || ZSTD_isError(ZSTD_initDStream(_zds))) {
+            ZSTD_freeDStream(_zds);
+            throw ReadError("Could not initialise zstd decompression for " + name);
+          }
+          return;
+        }
+        #endif
+        throw ReadError("Can't read compressed file " + name + ": LHAPDF was built without support for ." + extn + " files");
+      }
+
+      ~DecompressBuf() {
+        #ifdef HAVE_ZLIB
+        if (_zlib) inflateEnd(&_zs);
+        #endif
+        #ifdef HAVE_ZSTD
+        if (_zds != nullptr) ZSTD_freeDStream(_zds);
+        #endif
+      }
+
+
+    protected:
+
+      int_type underflow() {
+        if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+        const size_t n = _decompress(&_out[0], _out.size());
+        if (n == 0) return traits_type::eof();
+        setg(&_out[0], &_out[0], &_out[0] + n);
+        return traits_type::to_int_type(*gptr());
+      }
+
+      /// Bulk reads decompress straight into the caller's buffer, after draining the get area
+      std::streamsize xsgetn(char* s, std::streamsize count) {
+        std::streamsize n = std::min<std::streamsize>(count, egptr() - gptr());
+        if (n > 0) {
+          std::memcpy(s, gptr(), n);
+          gbump(n);
+        }
+        while (n < count) {
+          const size_t m = _decompress(s + n, count - n);
+          if (m == 0) break;
+          n += m;
+        }
+        return n;
+      }
+
+
+    private:
+
+      /// Decompress up to @a size bytes into @a dest, returning the number written, or 0 at the end of the data
+      size_t _decompress(char* dest, size_t size) {
+        size = std::min(size, size_t(1) << 30); //< within zlib's 32-bit buffer sizes
+        while (true) {
+          if (_inpos == _inlen) {
+            _inlen = _src->sgetn(&_in[0], _in.size());
+            _inpos = 0;
+          }
+          const size_t inavail = _inlen - _inpos;
+          size_t produced = 0;
+          #ifdef HAVE_ZLIB
+          if (_zlib) {
+            _zs.next_in = reinterpret_cast<Bytef*>(&_in[_inpos]);
+            _zs.avail_in = inavail;
+            _zs.next_out = reinterpret_cast<Bytef*>(dest);
+            _zs.avail_out = size;
+            const int rc = inflate(&_zs, Z_NO_FLUSH);
+            if (rc != Z_OK && rc != Z_STREAM_END && rc != Z_BUF_ERROR)
+              throw ReadError("Corrupt compressed data in " + _name + (_zs.msg ? std::string(": ") + _zs.msg : ""));
+            const size_t consumed = inavail - _zs.avail_in;
+            _inpos += consumed;
+            produced = size - _zs.avail_out;
+            if (rc == Z_STREAM_END) {
+              _ended = true;
+              inflateReset(&_zs); //< there may be another gzip member following
+            } else if (consumed > 0) {
+              _ended = false;
+            }
+          }
+          #endif
+          #ifdef HAVE_ZSTD
+          if (_zds != nullptr) {
+            ZSTD_inBuffer in = { &_in[_inpos], inavail, 0 };
+            ZSTD_outBuffer out = { dest, size, 0 };
+            const size_t rc = ZSTD_decompressStream(_zds, &out, &in);
+            if (ZSTD_isError(rc))
+              throw ReadError("Corrupt compressed data in " + _name + ": " + ZSTD_getErrorName(rc));
+            _inpos += in.pos;
+            produced = out.pos;
+            if (rc == 0) {
+              _ended = true; //< a frame is complete and fully flushed
+            } else if (in.pos > 0) {
+              _ended = false; //< not on a bare call at the end, which returns the next frame's header size
+            }
+          }
+          #endif
+          if (produced > 0) return produced;
+          if (inavail == 0) {
+            if (!_ended) throw ReadError("Compressed file " + _name + " is truncated");
+            return 0;
+          }
+        }
+      }
+
+
+      /// Chunk size for compressed reads and the decompressed get area
+      static const size_t CHUNKSIZE = 256*1024;
+
+      std::streambuf* _src;
+      std::string _name;
+      std::vector<char> _in, _out;
+      size_t _inpos, _inlen;
+      bool _ended;
+      #ifdef HAVE_ZLIB
+      bool _zlib = false;
+      z_stream _zs;
+      #endif
+      #ifdef HAVE_ZSTD
+      ZSTD_DStream* _zds = nullptr;
+      #endif
+
+    };
+
+  }
 
 
   template <class FILETYPE>
@@ -30,45 +287,46 @@ namespace LHAPDF {
       std::ifstream* is = dynamic_cast<std::ifstream*>(&*_fileptr);
       std::ofstream* os = dynamic_cast<std::ofstream*>(&*_fileptr);
       if (is) {
-        _streamptr = new std::stringstream();
-        FileContentMap::const_iterator it = lhapdf_filecontents.find(_name);
-        if (it != lhapdf_filecontents.end()) {
-          (*_streamptr) << it->second;
-        } else {
-          #ifdef HAVE_MPI
-          if (MPI::COMM_WORLD.Get_rank()) {
-            int fsize;
-            MPI::COMM_WORLD.Bcast(&fsize, 1, MPI_INT, 0);
+        std::shared_ptr<const std::string> content;
+        #ifdef HAVE_MPI
+        if (_collective) {
+          content = fileContentCache().get(_name);
+          if (!content) {
+            int rank(0);
+            MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+            std::shared_ptr<std::string> newcontent = std::make_shared<std::string>();
+            int fsize = -1;
+            if (rank == 0 && readFileContent(_name, *newcontent)) fsize = newcontent->length();
+            MPI_Bcast(&fsize, 1, MPI_INT, 0, MPI_COMM_WORLD);
             if (fsize < 0) return false;
-            std::string content(fsize, ' ');
-            MPI::COMM_WORLD.Bcast(&content[0], fsize, MPI_CHAR, 0);
-            (*_streamptr) << content;
-            lhapdf_filecontents[_name] = content;
-          } else {
-            std::ifstream infile(_name.c_str());
-            int fsize = infile.good() ? 1 : -1;
-            if (fsize < 0) {
-              MPI::COMM_WORLD.Bcast(&fsize, 1, MPI_INT, 0);
-              return false;
-            }
-            (*_streamptr) << infile.rdbuf();
-            std::string content(_streamptr->str());
-            fsize = content.length();
-            MPI::COMM_WORLD.Bcast(&fsize, 1, MPI_INT, 0);
-            MPI::COMM_WORLD.Bcast(&content[0], fsize, MPI_CHAR, 0);
-            lhapdf_filecontents[_name] = content;
+            newcontent->resize(fsize);
+            MPI_Bcast(&(*newcontent)[0], fsize, MPI_CHAR, 0, MPI_COMM_WORLD);
+            content = newcontent;
+            fileContentCache().put(_name, content);
           }
-          #else
-          std::ifstream infile(_name.c_str());
-          int fsize = infile.good() ? 1 : -1;
-          if (fsize < 0) return false;
-          (*_streamptr) << infile.rdbuf();
-          #endif
         }
-        _fileptr->copyfmt(*_streamptr);
-        _fileptr->clear(_streamptr->rdstate());
-        is->std::ios::rdbuf(_streamptr->rdbuf());
-        is->seekg(0);
+        #endif
+        if (!content) {
+          std::shared_ptr<std::string> newcontent = std::make_shared<std::string>();
+          if (!readFileContent(_name, *newcontent)) return false;
+          content = newcontent;
+        }
+        _contentptr = new SharedContentBuf(content);
+        if (isCompressedPath(_name)) {
+          // Decompress from the in-memory compressed content as the stream is read
+          try {
+            _bufptr = new DecompressBuf(_contentptr, _name);
+          } catch (...) {
+            close();
+            throw;
+          }
+          is->std::ios::rdbuf(_bufptr);
+          is->clear();
+          is->exceptions(std::ios::badbit); //< so that readers see decompression errors with their message
+          return true;
+        }
+        is->std::ios::rdbuf(_contentptr);
+        is->clear();
         return true;
       }
       if (os) {
@@ -88,16 +346,23 @@ namespace LHAPDF {
       std::ofstream* os = dynamic_cast<std::ofstream*>(&*_fileptr); ///< @todo Is this valid if not an ostream??
       do {
         #ifdef HAVE_MPI
-        if (MPI::COMM_WORLD.Get_rank() != 0) break;
+        int rank(0);
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        if (_collective && rank != 0) break;
         #endif
         if (os) {
           std::ofstream file(_name.c_str());
           file << _streamptr->str();
         }
       } while (false);
+      _fileptr->exceptions(std::ios::goodbit);
       _fileptr->close();
+      delete _bufptr;
+      delete _contentptr;
       delete _streamptr;
       delete _fileptr;
+      _bufptr = nullptr;
+      _contentptr = nullptr;
       _streamptr = nullptr;
       _fileptr = nullptr;
       return true;
@@ -108,8 +373,49 @@ namespace LHAPDF {
   template class OFile;
 
 
+  SharedContentBuf::SharedContentBuf(const std::shared_ptr<const std::string>& content)
+    : _content(content)
+  {
+    // The get area is never written through, despite the non-const streambuf interface
+    char* begin = const_cast<char*>(_content->data());
+    setg(begin, begin, begin + _content->size());
+  }
+
+
+  SharedContentBuf::pos_type SharedContentBuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+    if (!(which & std::ios_base::in)) return pos_type(off_type(-1));
+    const off_type pos = off + ((dir == std::ios_base::beg) ? 0 : (dir == std::ios_base::cur) ? gptr() - eback() : egptr() - eback());
+    if (pos < 0 || pos > egptr() - eback()) return pos_type(off_type(-1));
+    setg(eback(), eback() + pos, egptr());
+    return pos_type(pos);
+  }
+
+
+  SharedContentBuf::pos_type SharedContentBuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+  }
+
+
   void flushFileCache() {
-    lhapdf_filecontents.clear();
+    fileContentCache().clear();
+  }
+
+
+  void setFileCacheSize(size_t bytes) {
+    fileContentCache().setBudget(bytes);
+  }
+
+
+  const std::vector<std::string>& compressedExtns() {
+    static const std::vector<std::string> extns = {
+      #ifdef HAVE_ZSTD
+      "zst",
+      #endif
+      #ifdef HAVE_ZLIB
+      "gz",
+      #endif
+    };
+    return extns;
   }
 
 
@@ -7,11 +7,14 @@
 #include "LHAPDF/Interpolator.h"
 #include "LHAPDF/Factories.h"
 #include "LHAPDF/FileIO.h"
+#include "LHAPDF/BinaryGrid.h"
+#include "LHAPDF/Config.h"
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <stdexcept>
 #include <cstring>
+#include "NumScanner.h"
 
 using namespace std;
 
@@ -19,7 +22,9 @@ namespace LHAPDF {
 
 
   void GridPDF::setInterpolator(Interpolator* ipol) {
-    _interpolator.reset(ipol);
+    InterpolatorPtr p(ipol);
+    if (frozen()) throw LogicError("Can't change the interpolator of a frozen PDF");
+    _interpolator = std::move(p);
     _interpolator->bind(this);
   }
 
@@ -41,7 +46,9 @@ namespace LHAPDF {
 
 
   void GridPDF::setExtrapolator(Extrapolator* xpol) {
-    _extrapolator.reset(xpol);
+    ExtrapolatorPtr p(xpol);
+    if (frozen()) throw LogicError("Can't change the extrapolator of a frozen PDF");
+    _extrapolator = std::move(p);
     _extrapolator->bind(this);
   }
 
@@ -63,30 +70,64 @@ namespace LHAPDF {
 
   const KnotArrayNF& GridPDF::subgrid(double q2) const {
     assert(q2 >= 0);
+    _ensureData();
     assert(!q2Knots().empty());
-    map<double, KnotArrayNF>::const_iterator it = _knotarrays.upper_bound(q2);
-    if (it == _knotarrays.begin())
+    if (!_subgridIndexCurrent()) _indexSubgrids();
+    if (_subgridq2s.empty() || q2 < _subgridq2s.front())
       throw GridError("Requested Q2 " + to_str(q2) + " is lower than any available Q2 subgrid (lowest Q2 = " + to_str(q2Knots().front()) + ")");
-    if (it == _knotarrays.end() && q2 > q2Knots().back())
+    // Find the subgrid whose lower edge is the closest at or below q2
+    const size_t isub = _subgridindex.find(_subgridq2s, q2);
+    if (isub+1 == _subgridq2s.size() && q2 > q2Knots().back())
       throw GridError("Requested Q2 " + to_str(q2) + " is higher than any available Q2 subgrid (highest Q2 = " + to_str(q2Knots().back()) + ")");
-    --it; // upper_bound (and lower_bound) returns the entry *above* q2: we need to decrement by one element
-    // std::cout << "Using subgrid #" << std::distance(_knotarrays.begin(), it) << std::endl;
-    return it->second;
+    return *_subgridptrs[isub];
   }
 
 
-  const vector<double>& GridPDF::q2Knots() const {
-    if (_q2knots.empty()) {
-      // Get the list of Q2 knots by combining all subgrids
-      for (const pair<double, KnotArrayNF>& q2_ka : _knotarrays) {
-        const KnotArrayNF& subgrid = q2_ka.second;
-        const KnotArray1F& grid1 = subgrid.get_first();
-        if (grid1.q2s().empty()) continue; //< @todo This shouldn't be possible, right? Throw instead, or ditch the check?
-        for (double q2 : grid1.q2s()) {
-          if (_q2knots.empty() || q2 != _q2knots.back()) _q2knots.push_back(q2);
-        }
+  bool GridPDF::_subgridIndexCurrent() const {
+    if (!_subgridsindexed.load(std::memory_order_acquire)) return false;
+    // Catch subgrids added or removed through a reference from an earlier knotarrays() call
+    if (_subgridq2s.size() != _knotarrays.size()) return false;
+    return _knotarrays.empty() ||
+      (_subgridq2s.front() == _knotarrays.begin()->first && _subgridq2s.back() == _knotarrays.rbegin()->first);
+  }
+
+
+  void GridPDF::_indexSubgrids() const {
+    std::lock_guard<std::mutex> lock(_subgridmutex);
+    if (_subgridIndexCurrent()) return; //< already done by another thread
+    _subgridq2s.clear();
+    _subgridptrs.clear();
+    for (const pair<const double, KnotArrayNF>& q2_ka : _knotarrays) {
+      _subgridq2s.push_back(q2_ka.first);
+      _subgridptrs.push_back(&q2_ka.second);
+    }
+    _subgridindex = KnotIndex(_subgridq2s);
+    // Get the list of Q2 knots by combining all subgrids
+    _q2knots.clear();
+    for (const pair<const double, KnotArrayNF>& q2_ka : _knotarrays) {
+      const KnotArrayNF& subgrid = q2_ka.second;
+      const KnotArray1F& grid1 = subgrid.get_first();
+      if (grid1.q2s().empty()) continue; //< @todo This shouldn't be possible, right? Throw instead, or ditch the check?
+      for (double q2 : grid1.q2s()) {
+        if (_q2knots.empty() || q2 != _q2knots.back()) _q2knots.push_back(q2);
       }
     }
+    _gridgeneration.fetch_add(1, std::memory_order_release);
+    _subgridsindexed.store(true, std::memory_order_release);
+  }
+
+
+  void GridPDF::freeze() {
+    q2Knots(); //< also loads any deferred data
+    if (!_subgridIndexCurrent()) _indexSubgrids();
+    if (hasInterpolator()) _interpolator->freeze();
+    PDF::freeze();
+  }
+
+
+  const vector<double>& GridPDF::q2Knots() const {
+    _ensureData();
+    if (!_subgridIndexCurrent()) _indexSubgrids(); //< also lists the Q2 knots
     return _q2knots;
   }
 
@@ -111,124 +152,448 @@ namespace LHAPDF {
   }
 
 
+  void GridPDF::_xfxQ2(double x, double q2, const int* ids, double* out, size_t nids) const {
+    if (inRangeXQ2(x, q2)) {
+      interpolator().interpolateXQ2(x, q2, ids, out, nids);
+    } else {
+      for (size_t i = 0; i < nids; ++i)
+        out[i] = hasFlavor(ids[i]) ? extrapolator().extrapolateXQ2(ids[i], x, q2) : 0.0;
+    }
+  }
+
+
+  void GridPDF::_xfxQ2(int id, const double* xs, const double* q2s, double* out, size_t n) const {
+    // Find the out-of-range points: usually there are none, and the whole batch can be interpolated in place
+    vector<size_t> ixpol;
+    for (size_t i = 0; i < n; ++i)
+      if (!inRangeXQ2(xs[i], q2s[i])) ixpol.push_back(i);
+    if (ixpol.empty()) {
+      interpolator().interpolateXQ2(id, xs, q2s, out, n);
+      return;
+    }
+
+    // First pass: gather the in-range points, interpolate them in bulk, and scatter the results
+    vector<double> ipolxs, ipolq2s, ipolxfs;
+    vector<size_t> iipol;
+    for (size_t i = 0, j = 0; i < n; ++i) {
+      if (j < ixpol.size() && ixpol[j] == i) { ++j; continue; }
+      ipolxs.push_back(xs[i]);
+      ipolq2s.push_back(q2s[i]);
+      iipol.push_back(i);
+    }
+    if (!iipol.empty()) {
+      ipolxfs.resize(iipol.size());
+      interpolator().interpolateXQ2(id, &ipolxs[0], &ipolq2s[0], &ipolxfs[0], iipol.size());
+      for (size_t k = 0; k < iipol.size(); ++k) out[iipol[k]] = ipolxfs[k];
+    }
+
+    // Second pass: extrapolate the out-of-range points
+    for (size_t i : ixpol) out[i] = extrapolator().extrapolateXQ2(id, xs[i], q2s[i]);
+  }
+
+
+  void GridPDF::_tabulate(const vector<double>& xs, const vector<double>& q2s,
+                          const int* ids, size_t nids, double* out) const {
+    const size_t nx = xs.size(), nq2 = q2s.size();
+    const Interpolator& ipol = interpolator();
+
+    // Interpolation weights of the in-range x nodes, computed once for each subgrid knot geometry
+    struct XWeights {
+      const KnotGeometry* geom;
+      bool separable;
+      vector<Interpolator::AxisWeights> ws;
+      size_t ixmin, ixmax; //< range of x knots used
+    };
+    vector<XWeights> xweights;
+    vector<char> xinrange(nx);
+    for (size_t ix = 0; ix < nx; ++ix) xinrange[ix] = inRangeX(xs[ix]);
+
+    vector<double> row, xfs(nids);
+    for (size_t iq2 = 0; iq2 < nq2; ++iq2) {
+      const double q2 = q2s[iq2];
+      double* col = out + iq2; //< element [0][ix][iq2] is at col[ix*nq2]
+
+      // Extrapolate all flavors together at out-of-range Q2 nodes
+      if (!inRangeQ2(q2)) {
+        for (size_t ix = 0; ix < nx; ++ix) {
+          _xfxQ2(xs[ix], q2, ids, &xfs[0], nids);
+          for (size_t i = 0; i < nids; ++i) col[(i*nx + ix)*nq2] = xfs[i];
+        }
+        continue;
+      }
+
+      // Look up or compute the weights for this node's subgrid
+      const KnotArrayNF& sub = subgrid(q2);
+      const KnotGeometry& geom = *sub.geometry();
+      XWeights* xw = nullptr;
+      for (XWeights& w : xweights) if (w.geom == &geom) xw = &w;
+      if (xw == nullptr) {
+        xweights.push_back(XWeights{&geom, true, vector<Interpolator::AxisWeights>(nx), geom.xs().size(), 0});
+        xw = &xweights.back();
+        for (size_t ix = 0; ix < nx && xw->separable; ++ix) {
+          if (!xinrange[ix]) continue;
+          Interpolator::AxisWeights& aw = xw->ws[ix];
+          xw->separable = ipol._xWeights(geom, xs[ix], aw);
+          xw->ixmin = min(xw->ixmin, aw.i0);
+          xw->ixmax = max(xw->ixmax, aw.i0 + aw.n - 1);
+        }
+        if (xw->ixmin > xw->ixmax) xw->ixmin = xw->ixmax = 0; //< no in-range x nodes
+      }
+      Interpolator::AxisWeights qw;
+      const bool separable = xw->separable && ipol._q2Weights(geom, q2, qw);
+      row.resize(xw->ixmax - xw->ixmin + 1);
+
+      for (size_t i = 0; i < nids; ++i) {
+        double* flavcol = col + i*nx*nq2;
+        const KnotArray1F* grid = sub.find_pid(ids[i]);
+        // Undefined flavors are zero, and aliased ones copy the earlier result
+        if (grid == nullptr) {
+          for (size_t ix = 0; ix < nx; ++ix) flavcol[ix*nq2] = 0;
+          continue;
+        }
+        size_t ialias = i;
+        if (sub.has_aliases())
+          for (size_t j = 0; j < i && ialias == i; ++j)
+            if (sub.find_pid(ids[j]) == grid) ialias = j;
+        if (ialias != i) {
+          const double* aliascol = col + ialias*nx*nq2;
+          for (size_t ix = 0; ix < nx; ++ix) flavcol[ix*nq2] = aliascol[ix*nq2];
+          continue;
+        }
+        // Without separable weights, e.g. for a hand-filled grid with different knots per flavor, go point-by-point
+        if (!separable || grid->geometry().get() != &geom) {
+          for (size_t ix = 0; ix < nx; ++ix) flavcol[ix*nq2] = _xfxQ2(ids[i], xs[ix], q2);
+          continue;
+        }
+        // Interpolate the Q2 knot rows to this Q2 at each needed x knot, then sweep the x nodes
+        for (size_t k = xw->ixmin; k <= xw->ixmax; ++k) {
+          double v = 0;
+          for (size_t j = 0; j < qw.n; ++j) v += qw.w[j] * grid->xf(k, qw.i0 + j);
+          row[k - xw->ixmin] = v;
+        }
+        for (size_t ix = 0; ix < nx; ++ix) {
+          if (!xinrange[ix]) {
+            flavcol[ix*nq2] = extrapolator().extrapolateXQ2(ids[i], xs[ix], q2);
+            continue;
+          }
+          const Interpolator::AxisWeights& aw = xw->ws[ix];
+          const double* r = &row[aw.i0 - xw->ixmin];
+          double v = 0;
+          for (size_t j = 0; j < aw.n; ++j) v += aw.w[j] * r[j];
+          flavcol[ix*nq2] = v;
+        }
+      }
+    }
+  }
+
+
   namespace {
 
-    // A wrapper for std::strtod and std::strtol, for fast tokenizing when all
-    // input is guaranteed to be numeric (as in this data block). Based very
-    // closely on FastIStringStream by Gavin Salam.
-    class NumParser {
-    public:
-      // Constructor from char*
-      NumParser(const char* line=0) { reset(line); }
-      // Constructor from std::string
-      NumParser(const string& line) { reset(line); }
-
-      // Re-init to new line as char*
-      void reset(const char* line=0) {
-        _next = const_cast<char*>(line);
-        _new_next = _next;
-        _error = false;
+    // Read the metadata header of a member data stream, up to and including its "---" separator,
+    // returning the header text and setting @a nlines to the number of lines read
+    string _readHeader(istream& stream, int& nlines) {
+      string header, line;
+      nlines = 0;
+      while (getline(stream, line)) {
+        nlines += 1;
+        if (line == "---") break;
+        header += line + "\n";
       }
-      // Re-init to new line as std::string
-      void reset(const string& line) { reset(line.c_str()); }
-
-      // Tokenizing stream operator (forwards to double and int specialisations)
-      template<class T> NumParser& operator>>(T& value) {
-        _get(value);
-        if (_new_next == _next) _error = true; // handy error condition behaviour!
-        _next = _new_next;
-        return *this;
+      return header;
+    }
+
+    // Read the metadata header of the ASCII member file @a mempath, setting @a nlines to the number of
+    // header lines and @a offset to the byte offset of the data blocks, or -1 if it can't be told
+    string _readMemberHeader(const string& mempath, int& nlines, streamoff& offset) {
+      #ifndef HAVE_MPI
+      if (!isCompressedPath(mempath)) {
+        // Without MPI there is no need to buffer the whole file: read only as far as the header
+        ifstream file(mempath.c_str());
+        if (!file) throw ReadError("Could not open PDF data file '" + mempath + "'");
+        const string header = _readHeader(file, nlines);
+        offset = file.tellg();
+        return header;
       }
+      #endif
+      IFile file(mempath.c_str());
+      const string header = _readHeader(*file, nlines);
+      offset = file->tellg();
+      return header;
+    }
 
-      // Allow use of operator>> in a while loop
-      operator bool() const { return !_error; }
+    // Should the grids from @a mempath be loaded via the node-local shared-memory store?
+    // Binary grid files are already shared between processes through the page cache.
+    bool _useSharedGrids(const string& mempath) {
+      return !isBinaryGridPath(mempath) && getConfig().get_entry_as<bool>("SharedMemoryGrids", false);
+    }
 
-    private:
-      void _get(double& x) { x = std::strtod(_next, &_new_next); }
-      void _get(float& x) { x = std::strtof(_next, &_new_next); }
-      void _get(int& i) { i = std::strtol(_next, &_new_next, 10); } // force base 10!
+    // Should the grids from @a mempath be loaded via the persistent grid cache?
+    bool _useGridCache(const string& mempath) {
+      return !isBinaryGridPath(mempath) && !gridCacheDir().empty();
+    }
 
-      char *_next, *_new_next;
-      bool _error;
-    };
+  }
 
+
+  void GridPDF::_loadMember(const std::string& mempath) {
+    if (mempath.empty())
+      throw UserError("Tried to initialize a PDF with a null data file path... oops");
+    // Use a preloaded image of the member if one was registered, e.g. by the MPI set broadcast
+    size_t imagesize = 0;
+    const std::shared_ptr<const char> image = takeGridImage(mempath, imagesize);
+    if (image) {
+      string metadata;
+      if (_useSharedGrids(mempath)) {
+        readSharedGrid(mempath, _knotarrays, &metadata, [&]() { return string(image.get(), imagesize); });
+      } else {
+        readGridImage(image, imagesize, mempath, _knotarrays, &metadata);
+      }
+      istringstream stream(metadata);
+      _loadInfo(mempath, PDFInfo(stream, mempath));
+      _loadPlugins();
+      _finishData(mempath);
+      return;
+    }
+    if (!file_exists(mempath))
+      throw ReadError("PDF data file '" + mempath + "' not found");
+    if (getConfig().get_entry_as<bool>("LazyLoad", false)) {
+      // Read only the metadata header for now, and the grid data on first use
+      if (isBinaryGridPath(mempath)) {
+        _loadInfo(mempath);
+      } else {
+        istringstream header(_readMemberHeader(mempath, _nheaderlines, _dataoffset));
+        _loadInfo(mempath, PDFInfo(header, mempath));
+      }
+      _loadPlugins();
+      _checkFormat(mempath);
+      _dataloaded.store(false, std::memory_order_release);
+      return;
+    }
+    if (_useSharedGrids(mempath)) {
+      // Attach to this node's shared image of the parsed member, publishing it if necessary
+      string metadata;
+      readSharedGrid(mempath, _knotarrays, &metadata, [&]() { return _mkGridImage(mempath); });
+      istringstream stream(metadata);
+      _loadInfo(mempath, PDFInfo(stream, mempath));
+      _loadPlugins();
+    } else if (_useGridCache(mempath)) {
+      // Map the cached image of the parsed member, parsing it only if the cache entry is missing or stale
+      string metadata;
+      readCachedGrid(mempath, _knotarrays, &metadata, [&]() { return _mkGridImage(mempath); });
+      istringstream stream(metadata);
+      _loadInfo(mempath, PDFInfo(stream, mempath));
+      _loadPlugins();
+    } else if (isBinaryGridPath(mempath)) {
+      // Map the file once, for both the metadata header and the zero-copy grid data
+      string metadata;
+      readBinaryGrid(mempath, _knotarrays, &metadata);
+      istringstream stream(metadata);
+      _loadInfo(mempath, PDFInfo(stream, mempath));
+      _loadPlugins();
+    } else {
+      // Read the metadata header and then the data blocks, in a single pass through the file
+      IFile file(mempath.c_str());
+      int nheaderlines;
+      istringstream header(_readHeader(*file, nheaderlines));
+      _loadInfo(mempath, PDFInfo(header, mempath));
+      _loadPlugins();
+      _loadAsciiData(*file, mempath, nheaderlines, flavors().size());
+    }
+    _finishData(mempath);
   }
 
 
   void GridPDF::_loadData(const std::string& mempath) {
-    string line, prevline;
-    int iblock(0), iblockline(0), iline(0);
+    if (_useSharedGrids(mempath)) {
+      readSharedGrid(mempath, _knotarrays, nullptr, [&]() { return _mkGridImage(mempath); });
+    } else if (_useGridCache(mempath)) {
+      readCachedGrid(mempath, _knotarrays, nullptr, [&]() { return _mkGridImage(mempath); });
+    } else if (isBinaryGridPath(mempath)) {
+      readBinaryGrid(mempath, _knotarrays);
+    } else {
+      // Seek past the metadata header already read by _loadMember, or else read through it again.
+      // This may run at the first query, which not every MPI rank reaches, so the read is not collective.
+      IFile file(mempath.c_str(), false);
+      int nheaderlines = _nheaderlines;
+      if (_dataoffset < 0 || !file->seekg(_dataoffset)) {
+        file->clear();
+        _readHeader(*file, nheaderlines);
+      }
+      _loadAsciiData(*file, mempath, nheaderlines, flavors().size());
+    }
+    _finishData(mempath);
+  }
+
+
+  std::string GridPDF::_mkGridImage(const std::string& mempath) {
+    // Split off the metadata header text, which is stored verbatim in the image
+    IFile file(mempath.c_str(), false);
+    int nheaderlines;
+    const string metadata = _readHeader(*file, nheaderlines);
+    // The flavor list is read from a local copy of the metadata, since this may be a
+    // deferred load of a const PDF whose live metadata must not be replaced
+    istringstream stream(metadata);
+    const PDFInfo info(stream, mempath);
+    vector<int> pids = info.get_entry_as< vector<int> >("Flavors");
+    sort(pids.begin(), pids.end());
+    _loadAsciiData(*file, mempath, nheaderlines, pids.size());
+    return binaryGridImage(_knotarrays, pids, metadata);
+  }
+
+
+  void GridPDF::_loadDeferredData() const {
+    std::call_once(_dataonce, [this]() {
+      GridPDF* self = const_cast<GridPDF*>(this); //< the grids are logically part of this const object
+      try {
+        self->_loadData(_mempath);
+      } catch (...) {
+        // Discard any partially-loaded subgrids, so a later call can retry cleanly
+        self->_knotarrays.clear();
+        throw;
+      }
+      _dataloaded.store(true, std::memory_order_release);
+    });
+  }
+
+
+  void GridPDF::_checkFormat(const std::string& mempath) const {
+    const string fmt = info().get_entry("Format", "lhagrid1");
+    if (fmt != "lhagrid1")
+      throw FactoryError("PDF data file " + mempath + " has format type '" + fmt + "', which can't be loaded as a GridPDF");
+  }
+
+
+  void GridPDF::_finishData(const std::string& mempath) {
+    _checkFormat(mempath);
+    _subgridsindexed.store(false, std::memory_order_release);
+    for (const pair<const double, KnotArrayNF>& q2_ka : _knotarrays) {
+      if (q2_ka.second.size() != flavors().size())
+        throw ReadError("PDF grid data error in " + mempath + ": " + to_str(q2_ka.second.size()) +
+                        " parton flavors declared but " + to_str(flavors().size()) + " expected from Flavors metadata");
+    }
+
+    // Store flavors with identical grids only once: explicitly declared aliases
+    // are given as a flat list of (alias, target) PID pairs, e.g. [-3, 3], and
+    // must match the data, since the alias's own grid is discarded
+    if (info().has_key("FlavorAliases")) {
+      const vector<int> aliases = info().get_entry_as< vector<int> >("FlavorAliases");
+      if (aliases.size() % 2 != 0)
+        throw MetadataError("FlavorAliases in " + mempath + " must be a list of (alias, target) PID pairs");
+      for (pair<const double, KnotArrayNF>& q2_ka : _knotarrays) {
+        for (size_t i = 0; i < aliases.size(); i += 2) {
+          if (!q2_ka.second.has_pid(aliases[i])) continue;
+          if (q2_ka.second.has_pid(aliases[i+1]) && !q2_ka.second.same_grid(aliases[i], aliases[i+1]))
+            throw ReadError("FlavorAliases in " + mempath + " declares PID " + to_str(aliases[i]) + " an alias of PID " +
+                            to_str(aliases[i+1]) + ", but their grids differ in the subgrid from Q2 = " + to_str(q2_ka.first));
+          q2_ka.second.alias_pid(aliases[i], aliases[i+1]);
+        }
+      }
+    }
+    if (info().get_entry_as<bool>("AliasFlavors", false)) {
+      for (pair<const double, KnotArrayNF>& q2_ka : _knotarrays) q2_ka.second.alias_identical();
+    }
+
+    // Optionally repack each subgrid into the flavor-interleaved storage layout, or
+    // else re-encode the xf values at a reduced storage precision: the interleaved
+    // layout is double-precision only, so the options can't be combined
+    const string prec = to_lower(info().get_entry("XfPrecision", "double"));
+    if (prec != "double" && prec != "float" && prec != "log16")
+      throw MetadataError("Unknown XfPrecision '" + prec + "': use 'double', 'float' or 'log16'");
+    if (info().get_entry_as<bool>("InterleaveFlavors", false)) {
+      if (prec != "double")
+        throw MetadataError("XfPrecision '" + prec + "' can't be used with InterleaveFlavors, whose storage is double-precision only");
+      for (pair<const double, KnotArrayNF>& q2_ka : _knotarrays) q2_ka.second.interleave();
+    } else if (prec != "double") {
+      const KnotArray1F::Precision p = (prec == "float") ? KnotArray1F::FLOAT : KnotArray1F::LOG16;
+      for (pair<const double, KnotArrayNF>& q2_ka : _knotarrays) q2_ka.second.setPrecision(p);
+    }
+  }
+
+
+  void GridPDF::_loadAsciiData(std::istream& stream, const std::string& mempath, int nheaderlines, size_t nflavors) {
+    // Block 0, the metadata, has already been read up to and including its "---" separator, if present
+    const bool atend = stream.eof();
+    int iblock(1), iblockline(0), iline(nheaderlines);
     vector<double> xs, q2s;
     vector<int> pids;
     vector< vector<double> > ipid_xfs;
 
     try {
-      IFile file(mempath.c_str());
-      NumParser nparser; double ftoken; int itoken;
-      while (getline(*file, line)) {
-        // Trim the current line to ensure that there is no effect of leading spaces, etc.
-        line = trim(line);
-        prevline = line; // used to test the last line after the while loop fails
-
-        // If the line is commented out, increment the line number but not the block line
-        iline += 1;
-        if (line.find("#") == 0) continue;
-        iblockline += 1;
-
-        if (line != "---") { // if we are not on a block separator line...
-
-          // Block 0 is the metadata, which we ignore here
-          if (iblock == 0) continue;
-
-          // Debug printout
-          // cout << iline << " = block line #" << iblockline << " => " << line << endl;
-
-          // Parse the data lines
-          nparser.reset(line);
-          if (iblockline == 1) { // x knots line
-            while (nparser >> ftoken) xs.push_back(ftoken);
-            if (xs.empty())
-              throw ReadError("Empty x knot array on line " + to_str(iline));
-          } else if (iblockline == 2) { // Q knots line
-            while (nparser >> ftoken) q2s.push_back(ftoken*ftoken); // note Q -> Q2
-            if (q2s.empty())
-              throw ReadError("Empty Q knot array on line " + to_str(iline));
-          } else if (iblockline == 3) { // internal flavor IDs ordering line
-            while (nparser >> itoken) pids.push_back(itoken);
-            // Check that each line has many tokens as there should be flavours
-            if (pids.size() != flavors().size())
-              throw ReadError("PDF grid data error on line " + to_str(iline) + ": " + to_str(pids.size()) +
-                              " parton flavors declared but " + to_str(flavors().size()) + " expected from Flavors metadata");
-            /// @todo Handle sea/valence representations via internal pseudo-PIDs
-          } else {
-            if (iblockline == 4) { // on the first line of the xf block, resize the arrays
-              ipid_xfs.resize(pids.size());
-              const size_t subgridsize = xs.size()*q2s.size();
-              for (size_t ipid = 0; ipid < pids.size(); ++ipid) {
-                ipid_xfs[ipid].reserve(subgridsize);
+      // Whether the last line seen, used to test the termination after the loop, was a separator
+      bool anyline = false, lastsep = false;
+
+      // Parse the lines in [bufbegin, bufend), returning the start of a trailing partial
+      // line that is left unparsed unless this is the final part of the stream
+      double ftoken; int itoken;
+      auto parseLines = [&](const char* bufbegin, const char* bufend, bool final) -> const char* {
+        for (const char* next = bufbegin; next < bufend; ) {
+          // Find the line, and trim it to ensure that there is no effect of leading spaces, etc.
+          const char* eol = static_cast<const char*>(memchr(next, '\n', bufend - next));
+          if (eol == nullptr) {
+            if (!final) return next;
+            eol = bufend;
+          }
+          const char* lbegin = next;
+          const char* lend = eol;
+          next = eol + 1;
+          while (lbegin != lend && *lbegin == ' ') ++lbegin;
+          while (lend != lbegin && *(lend-1) == ' ') --lend;
+          anyline = true;
+          lastsep = (lend - lbegin == 3 && memcmp(lbegin, "---", 3) == 0);
+
+          // If the line is commented out, increment the line number but not the block line
+          iline += 1;
+          if (lbegin != lend && *lbegin == '#') continue;
+          iblockline += 1;
+
+          if (lend - lbegin != 3 || memcmp(lbegin, "---", 3) != 0) { // if we are not on a block separator line...
+
+            // Parse the data lines
+            NumScanner<> nparser(lbegin, lend);
+            if (iblockline == 1) { // x knots line
+              while (nparser.next(ftoken)) xs.push_back(ftoken);
+              if (xs.empty())
+                throw ReadError("Empty x knot array on line " + to_str(iline));
+            } else if (iblockline == 2) { // Q knots line
+              while (nparser.next(ftoken)) q2s.push_back(ftoken*ftoken); // note Q -> Q2
+              if (q2s.empty())
+                throw ReadError("Empty Q knot array on line " + to_str(iline));
+            } else if (iblockline == 3) { // internal flavor IDs ordering line
+              while (nparser.next(itoken)) pids.push_back(itoken);
+              // Check that each line has many tokens as there should be flavours
+              if (pids.size() != nflavors)
+                throw ReadError("PDF grid data error on line " + to_str(iline) + ": " + to_str(pids.size()) +
+                                " parton flavors declared but " + to_str(nflavors) + " expected from Flavors metadata");
+              /// @todo Handle sea/valence representations via internal pseudo-PIDs
+            } else {
+              if (iblockline == 4) { // on the first line of the xf block, resize the arrays
+                ipid_xfs.resize(pids.size());
+                const size_t subgridsize = xs.size()*q2s.size();
+                for (size_t ipid = 0; ipid < pids.size(); ++ipid) {
+                  ipid_xfs[ipid].reserve(subgridsize);
+                }
               }
+              size_t ipid = 0;
+              while (nparser.next(ftoken)) {
+                if (ipid == ipid_xfs.size())
+                  throw ReadError("PDF grid data error on line " + to_str(iline) + ": more than " +
+                                  to_str(pids.size()) + " flavor entries seen");
+                ipid_xfs[ipid].push_back(ftoken);
+                ipid += 1;
+              }
+              // Check that each line has many tokens as there should be flavours
+              if (ipid != pids.size())
+                throw ReadError("PDF grid data error on line " + to_str(iline) + ": " + to_str(ipid) +
+                                " flavor entries seen but " + to_str(pids.size()) + " expected");
             }
-            size_t ipid = 0;
-            while (nparser >> ftoken) {
-              ipid_xfs[ipid].push_back(ftoken);
-              ipid += 1;
-            }
-            // Check that each line has many tokens as there should be flavours
-            if (ipid != pids.size())
-              throw ReadError("PDF grid data error on line " + to_str(iline) + ": " + to_str(ipid) +
-                              " flavor entries seen but " + to_str(pids.size()) + " expected");
-          }
-
-        } else { // we *are* on a block separator line
 
-          // Check that the expected number of data lines were seen in the last block
-          if (iblock > 0 && iblockline - 1 != int(xs.size()*q2s.size()) + 3)
-            throw ReadError("PDF grid data error on line " + to_str(iline) + ": " +
-                            to_str(iblockline-1) + " data lines were seen in block " + to_str(iblock-1) +
-                            " but " + to_str(xs.size()*q2s.size() + 3) + " expected");
+          } else { // we *are* on a block separator line
 
-          // Ignore block registration if we've just finished reading the 0th (metadata) block
-          if (iblock > 0) {
+            // Check that the expected number of data lines were seen in the last block
+            if (iblockline - 1 != int(xs.size()*q2s.size()) + 3)
+              throw ReadError("PDF grid data error on line " + to_str(iline) + ": " +
+                              to_str(iblockline-1) + " data lines were seen in block " + to_str(iblock-1) +
+                              " but " + to_str(xs.size()*q2s.size() + 3) + " expected");
 
             // Throw if the last subgrid block was of zero size
             if (ipid_xfs.empty())
@@ -236,26 +601,49 @@ namespace LHAPDF {
 
             // Register data from the block into the GridPDF data structure
             KnotArrayNF& arraynf = _knotarrays[q2s.front()]; //< Reference to newly created subgrid object
+            const shared_ptr<const KnotGeometry> geom = KnotGeometry::mk(xs, q2s); //< Shared by all flavors (and usually all members)
             for (size_t ipid = 0; ipid < pids.size(); ++ipid) {
               const int pid = pids[ipid];
               // Create the 2D array with the x and Q2 knot positions
-              arraynf[pid] = KnotArray1F(xs, q2s);
+              arraynf[pid] = KnotArray1F(geom);
               // Populate the xf data array
               arraynf[pid].setxfs(ipid_xfs[ipid]);
             }
-          }
 
-          // Increment/reset the block and line counters, subgrid arrays, etc.
-          iblock += 1;
-          iblockline = 0;
-          xs.clear(); q2s.clear();
-          for (size_t ipid = 0; ipid < pids.size(); ++ipid)
-            ipid_xfs[ipid].clear();
-          pids.clear();
+            // Increment/reset the block and line counters, subgrid arrays, etc.
+            iblock += 1;
+            iblockline = 0;
+            xs.clear(); q2s.clear();
+            for (size_t ipid = 0; ipid < pids.size(); ++ipid)
+              ipid_xfs[ipid].clear();
+            pids.clear();
+          }
+        }
+        return bufend;
+      };
+
+      // Scan the rest of the stream in place if it is in-memory file content, or else decompress
+      // and parse it a chunk at a time, carrying each chunk's trailing partial line over to the next
+      const SharedContentBuf* content = dynamic_cast<const SharedContentBuf*>(stream.rdbuf());
+      if (content != nullptr) {
+        parseLines(content->unreadBegin(), content->unreadEnd(), true);
+      } else {
+        const size_t CHUNKSIZE = 1 << 20;
+        string buf;
+        size_t ncarried = 0;
+        while (stream) {
+          buf.resize(ncarried + CHUNKSIZE);
+          stream.read(&buf[ncarried], CHUNKSIZE);
+          buf.resize(ncarried + stream.gcount());
+          const char* rest = parseLines(buf.data(), buf.data() + buf.size(), !stream);
+          ncarried = buf.data() + buf.size() - rest;
+          buf.erase(0, buf.size() - ncarried);
         }
       }
+
       // File reading finished: complain if it was not properly terminated
-      if (prevline != "---")
+      const bool terminated = anyline ? lastsep : !atend;
+      if (!terminated)
         throw ReadError("Grid file " + mempath + " is not properly terminated: .dat files MUST end with a --- separator line");
 
       // Error handling
@@ -6,6 +6,10 @@
 #include "LHAPDF/Info.h"
 #include "LHAPDF/PDFIndex.h"
 #include "LHAPDF/FileIO.h"
+#include "LHAPDF/BinaryGrid.h"
+#include <fstream>
+#include <set>
+#include <algorithm>
 
 #include "yaml-cpp/yaml.h"
 #ifdef YAML_NAMESPACE
@@ -15,6 +19,52 @@
 namespace LHAPDF {
 
 
+  std::atomic<uint64_t> Info::_generation(0);
+
+
+  void Info::TypedCache::compact() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::set<const Slot*> shadowed;
+    for (std::atomic<const Slot*>& head : _buckets) {
+      // Relink each bucket's list with only the newest slot for each key and type
+      Slot* last = nullptr;
+      for (const Slot* slot = head.load(std::memory_order_relaxed); slot != nullptr; slot = slot->next) {
+        if (_find(head.load(std::memory_order_relaxed), slot->key, *slot->type) != slot) {
+          shadowed.insert(slot);
+        } else {
+          if (last != nullptr) last->next = slot;
+          last = const_cast<Slot*>(slot); //< owned, non-const, by _slots
+        }
+      }
+      if (last != nullptr) last->next = nullptr;
+    }
+    if (shadowed.empty()) return;
+    _slots.erase(std::remove_if(_slots.begin(), _slots.end(),
+                                [&](const std::unique_ptr<Slot>& slot) { return shadowed.count(slot.get()) > 0; }),
+                 _slots.end());
+  }
+
+
+  void Info::TypedCache::clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _reset();
+    _slots.clear();
+  }
+
+
+  const void* Info::TypedCache::_publish(const string& key, const std::type_info& type, const string& s,
+                                         const std::shared_ptr<const void>& value, uint64_t generation) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::atomic<const Slot*>& head = _buckets[_bucket(key)];
+    const Slot* current = _find(head.load(std::memory_order_relaxed), key, type);
+    if (current != nullptr && current->src == s) return current->value.get(); //< published by another thread
+    // Push a new slot, shadowing any stale one for the same key and type
+    _slots.emplace_back(new Slot(key, type, s, value, generation, head.load(std::memory_order_relaxed)));
+    head.store(_slots.back().get(), std::memory_order_release);
+    return value.get();
+  }
+
+
   void Info::load(const string& filepath) {
     // Complain if the path is empty
     if (filepath.empty()) throw ReadError("Empty PDF file name given to Info::load");
@@ -22,13 +72,36 @@ namespace LHAPDF {
     // But complain if a non-empty path is provided, but it's invalid
     if (!file_exists(filepath)) throw ReadError("PDF data file '" + filepath + "' not found");
 
-    // Read the YAML part of the file into the metadata map
+    // Read the YAML part of the file, or the embedded header of a binary grid file, into the metadata map
+    if (isBinaryGridPath(filepath)) {
+      istringstream stream(readBinaryGridMetadata(filepath));
+      load(stream, filepath);
+    } else {
+      #ifdef HAVE_MPI
+      IFile file(filepath.c_str());
+      load(*file, filepath);
+      #else
+      // Compressed files are decompressed as the stream is read, so again only the header is unpacked
+      if (isCompressedPath(filepath)) {
+        IFile file(filepath.c_str());
+        load(*file, filepath);
+        return;
+      }
+      // Without MPI there is no need to buffer the whole file: read only as far as the header
+      ifstream file(filepath.c_str());
+      if (!file) throw ReadError("Could not open PDF data file '" + filepath + "'");
+      load(file, filepath);
+      #endif
+    }
+  }
+
+
+  void Info::load(istream& stream, const string& name) {
     try {
 
-      // Do the parsing "manually" up to the first doc delimiter
-      IFile file(filepath.c_str());
+      // Do the parsing "manually" up to the first doc delimiter, leaving the stream positioned after it
       string docstr, line;
-      while (getline(*file, line)) {
+      while (getline(stream, line)) {
         if (line == "---") break;
         docstr += line + "\n";
       }
@@ -53,13 +126,14 @@ namespace LHAPDF {
         //   _metadict[key] = seqstr;
         // }
       }
+      _changed();
 
     } catch (const YAML::ParserException& ex) {
-      throw ReadError("YAML parse error in " + filepath + " :" + ex.what());
+      throw ReadError("YAML parse error in " + name + " :" + ex.what());
     } catch (const LHAPDF::Exception& ex) {
       throw;
     } catch (const std::exception& ex) {
-      throw ReadError("Trouble when reading " + filepath + " :" + ex.what());
+      throw ReadError("Trouble when reading " + name + " :" + ex.what());
     }
 
   }
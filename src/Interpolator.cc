@@ -26,4 +26,31 @@ double Interpolator::interpolateXQ2(int id, double x, double q2) const {
     }
 
 
+  void Interpolator::interpolateXQ2(double x, double q2, const int* ids, double* out, size_t nids) const {
+    // Subgrid and index look-ups, done once for all flavors
+    const KnotArrayNF& subgrid = pdf().subgrid(q2);
+    const size_t ix = subgrid.ixbelow(x);
+    const size_t iq2 = subgrid.iq2below(q2);
+    _interpolateXQ2(subgrid, x, ix, q2, iq2, ids, out, nids);
+  }
+
+
+  void Interpolator::_interpolateXQ2(const KnotArrayNF& subgrid, double x, size_t ix, double q2, size_t iq2,
+                                     const int* ids, double* out, size_t nids) const {
+    const KnotGeometry* geom = subgrid.get_first().geometry().get();
+    for (size_t i = 0; i < nids; ++i) {
+      const KnotArray1F* grid = subgrid.find_pid(ids[i]);
+      if (grid == nullptr) {
+        out[i] = 0;
+      } else if (subgrid.has_aliases() && _reuseAliased(subgrid, grid, ids, out, i)) {
+        continue;
+      } else if (grid->geometry().get() == geom) {
+        out[i] = _interpolateXQ2(*grid, x, ix, q2, iq2);
+      } else { // a hand-filled grid may have different knots for each flavor
+        out[i] = _interpolateXQ2(*grid, x, grid->ixbelow(x), q2, grid->iq2below(q2));
+      }
+    }
+  }
+
+
 }
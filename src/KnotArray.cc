@@ -0,0 +1,196 @@
+// -*- C++ -*-
+//
+// This file is part of LHAPDF
+// Copyright (C) 2012-2019 The LHAPDF collaboration (see AUTHORS for details)
+//
+#include "LHAPDF/KnotArray.h"
+#include <cstring>
+#include <cstdint>
+#include <mutex>
+#include <cmath>
+
+namespace LHAPDF {
+
+
+  namespace {
+
+    /// Maximum number of buckets in a knot index table
+    const uint64_t MAXKNOTBUCKETS = 4096;
+
+    /// Registry of live geometries, binned by hash
+    typedef map<size_t, vector< weak_ptr<const KnotGeometry> > > GeometryRegistry;
+
+    GeometryRegistry& _registry() {
+      static GeometryRegistry reg;
+      return reg;
+    }
+
+    std::mutex& _registryMutex() {
+      static std::mutex m;
+      return m;
+    }
+
+    /// FNV-1a hashing of the raw bytes of a double array, continuing from @a h
+    size_t _hashDoubles(const vector<double>& ds, uint64_t h) {
+      const uint64_t FNV_PRIME = 1099511628211ULL;
+      for (double d : ds) {
+        uint64_t bits;
+        memcpy(&bits, &d, sizeof(double));
+        for (int i = 0; i < 8; ++i) {
+          h ^= (bits >> (8*i)) & 0xff;
+          h *= FNV_PRIME;
+        }
+      }
+      // Mix in the length, to distinguish the x/Q2 split point
+      h ^= ds.size();
+      h *= FNV_PRIME;
+      return h;
+    }
+
+  }
+
+
+  KnotIndex::KnotIndex(const vector<double>& knots)
+    : _base(0), _shift(0)
+  {
+    // Only usable for sorted, non-negative, finite knots: otherwise leave the table empty, for binary searches
+    if (knots.size() < 2 || std::signbit(knots.front()) || !std::isfinite(knots.back())) return;
+    for (size_t i = 0; i+1 < knots.size(); ++i)
+      if (!(knots[i] <= knots[i+1])) return;
+
+    // Aim for several buckets per knot, within a fixed maximum table size
+    _base = _bits(knots.front());
+    const uint64_t range = _bits(knots.back()) - _base;
+    const uint64_t maxbuckets = std::min<uint64_t>(8*knots.size(), MAXKNOTBUCKETS);
+    while ((range >> _shift) >= maxbuckets) _shift += 1;
+    _table.resize((range >> _shift) + 1);
+
+    // Record the last knot at or below each bucket's lower edge
+    size_t i = 0;
+    for (size_t ib = 0; ib < _table.size(); ++ib) {
+      const uint64_t edge = _base + (uint64_t(ib) << _shift);
+      while (i+1 < knots.size() && _bits(knots[i+1]) <= edge) i += 1;
+      _table[ib] = i;
+    }
+  }
+
+
+  KnotGeometry::KnotGeometry(const vector<double>& xknots, const vector<double>& q2knots)
+    : _xs(xknots), _q2s(q2knots),
+      _hash(computeHash(xknots, q2knots))
+  {
+    _logxs.resize(_xs.size());
+    _logq2s.resize(_q2s.size());
+    for (size_t i = 0; i < _xs.size(); ++i) _logxs[i] = log(_xs[i]);
+    for (size_t i = 0; i < _q2s.size(); ++i) _logq2s[i] = log(_q2s[i]);
+    _xindex = KnotIndex(_xs);
+    _q2index = KnotIndex(_q2s);
+  }
+
+
+  size_t KnotGeometry::computeHash(const vector<double>& xknots, const vector<double>& q2knots) {
+    const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+    return _hashDoubles(q2knots, _hashDoubles(xknots, FNV_OFFSET));
+  }
+
+
+  shared_ptr<const KnotGeometry> KnotGeometry::mk(const vector<double>& xknots, const vector<double>& q2knots) {
+    const size_t h = computeHash(xknots, q2knots);
+    std::lock_guard<std::mutex> lock(_registryMutex());
+    vector< weak_ptr<const KnotGeometry> >& bin = _registry()[h];
+    for (size_t i = 0; i < bin.size(); ++i) {
+      shared_ptr<const KnotGeometry> g = bin[i].lock();
+      if (!g) continue;
+      if (g->xs() == xknots && g->q2s() == q2knots) return g;
+    }
+    // Not yet registered: discard any expired entries in this bin, and add the new geometry
+    bin.erase(remove_if(bin.begin(), bin.end(), [](const weak_ptr<const KnotGeometry>& w) { return w.expired(); }), bin.end());
+    shared_ptr<const KnotGeometry> g(new KnotGeometry(xknots, q2knots));
+    bin.push_back(g);
+    return g;
+  }
+
+
+  const shared_ptr<const KnotGeometry>& KnotGeometry::empty() {
+    static const shared_ptr<const KnotGeometry> g = mk(vector<double>(), vector<double>());
+    return g;
+  }
+
+
+  size_t KnotGeometry::numRegistered() {
+    std::lock_guard<std::mutex> lock(_registryMutex());
+    size_t n = 0;
+    for (const GeometryRegistry::value_type& h_bin : _registry())
+      for (const weak_ptr<const KnotGeometry>& w : h_bin.second)
+        if (!w.expired()) n += 1;
+    return n;
+  }
+
+
+
+  const size_t KnotArray1F::LOG16BLOCK;
+  constexpr double KnotArray1F::LOG16RANGE;
+
+
+  void KnotArray1F::setPrecision(Precision prec) {
+    if (prec == _precision && !shared()) return;
+
+    // Gather the current values at full precision
+    const size_t n = size();
+    vector<double> vals(n);
+    for (size_t i = 0; i < n; ++i) vals[i] = xf(i / q2size(), i % q2size());
+    if (prec == DOUBLE) {
+      setxfs(vals);
+      return;
+    }
+
+    vector<float> fvals;
+    vector<uint16_t> codes;
+    vector<double> scales;
+    if (prec == FLOAT) {
+      fvals.assign(vals.begin(), vals.end());
+    } else {
+      codes.resize(n);
+      scales.resize(2*((n + LOG16BLOCK - 1) / LOG16BLOCK));
+      for (size_t ib = 0; ib*LOG16BLOCK < n; ++ib) {
+        const size_t i0 = ib*LOG16BLOCK, i1 = std::min(i0 + LOG16BLOCK, n);
+        // Find the log2|xf| range of the block's non-zero values, capped below the maximum
+        double lmin = HUGE_VAL, lmax = -HUGE_VAL;
+        for (size_t i = i0; i < i1; ++i) {
+          if (!std::isfinite(vals[i]))
+            throw GridError("Can't store non-finite xf value " + to_str(vals[i]) + " with LOG16 precision");
+          if (vals[i] == 0) continue;
+          const double l = std::log2(std::abs(vals[i]));
+          lmin = std::min(lmin, l);
+          lmax = std::max(lmax, l);
+        }
+        if (lmax == -HUGE_VAL) continue; //< all zero: codes are already 0
+        lmin = std::max(lmin, lmax - LOG16RANGE);
+        const double step = (lmax - lmin) / 32766;
+        scales[2*ib] = lmin;
+        scales[2*ib+1] = step;
+        // Encode as a sign bit and a magnitude code, with codes 1..32767 spanning [lmin, lmax]
+        for (size_t i = i0; i < i1; ++i) {
+          if (vals[i] == 0) continue;
+          const double l = std::log2(std::abs(vals[i]));
+          if (l < lmin - (step > 0 ? step : 1)/2) continue; //< flush to zero
+          const double c = (step > 0) ? std::round((l - lmin) / step) : 0;
+          const uint16_t mag = 1 + uint16_t(std::min(std::max(c, 0.0), 32766.0));
+          codes[i] = mag | (vals[i] < 0 ? 0x8000 : 0);
+        }
+      }
+    }
+
+    // Swap in the new storage, releasing any double-precision values
+    std::vector<double>().swap(_xfs);
+    _xfshared.reset();
+    _xfstride = 1;
+    _xfsfloat.swap(fvals);
+    _xfslog16.swap(codes);
+    _log16scales.swap(scales);
+    _precision = prec;
+    _version = _nextVersion();
+  }
+
+
+}
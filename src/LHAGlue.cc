@@ -762,12 +762,18 @@ extern "C" {
   void evolvepdfm_(const int& nset, const double& x, const double& q, double* fxq) {
     if (ACTIVESETS.find(nset) == ACTIVESETS.end())
       throw LHAPDF::UserError("Trying to use LHAGLUE set #" + LHAPDF::to_str(nset) + " but it is not initialised");
-    // Evaluate for the 13 LHAPDF5 standard partons (-6..6)
-    for (int i = 0; i < 13; ++i) {
-      try {
-        fxq[i] = ACTIVESETS[nset].activeMember()->xfxQ(i-6, x, q);
-      } catch (const exception& e) {
-        fxq[i] = 0;
+    // Evaluate for the 13 LHAPDF5 standard partons (-6..6), all at once
+    const PDFPtr pdf = ACTIVESETS[nset].activeMember();
+    try {
+      pdf->xfxQ2(x, q*q, fxq);
+    } catch (const exception& e) {
+      // Fall back to per-flavor evaluation, zeroing only the failing partons
+      for (int i = 0; i < 13; ++i) {
+        try {
+          fxq[i] = pdf->xfxQ(i-6, x, q);
+        } catch (const exception& e) {
+          fxq[i] = 0;
+        }
       }
     }
     // Update current set focus
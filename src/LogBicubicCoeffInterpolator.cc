@@ -0,0 +1,188 @@
+// -*- C++ -*-
+//
+// This file is part of LHAPDF
+// Copyright (C) 2012-2019 The LHAPDF collaboration (see AUTHORS for details)
+//
+#include "LHAPDF/LogBicubicCoeffInterpolator.h"
+#include "LHAPDF/GridPDF.h"
+
+namespace LHAPDF {
+
+
+  namespace { // Unnamed namespace
+
+    /// Power-basis coefficients of the cubic Hermite spline with end values p0, p1 and scaled slopes m0, m1
+    inline void _hermiteCoeffs(double p0, double m0, double p1, double m1, double* k) {
+      k[0] = p0;
+      k[1] = m0;
+      k[2] = -3*p0 - 2*m0 + 3*p1 - m1;
+      k[3] = 2*p0 + m0 - 2*p1 + m1;
+    }
+
+  }
+
+
+  void LogBicubicCoeffInterpolator::_computeCoeffs(const KnotArray1F& grid, std::vector<double>& coeffs) {
+    const size_t nx = grid.xsize(), nq2 = grid.q2size();
+    coeffs.clear();
+    if (nx < 2 || nq2 < 2) return; //< no cells: interpolation will throw, as for LogBicubicInterpolator
+    coeffs.assign(16*(nx-1)*(nq2-1), 0.0);
+    if (nx < 4) return; //< also too small for interpolation
+    const vector<double>& logq2s = grid.logq2s();
+    Stencil s;
+    s.nxknots = nx;
+    s.nq2knots = nq2;
+    s.logxs = &grid.logxs()[0];
+    s.logq2s = &logq2s[0];
+
+    vector<double> rows(4*nq2);
+    for (size_t ix = 0; ix+1 < nx; ++ix) {
+      // Polynomial coefficients in t_x of every Q2 knot row across this x cell
+      const double dlogx_1 = s.logxs[ix+1] - s.logxs[ix];
+      for (size_t iq2 = 0; iq2 < nq2; ++iq2) {
+        double* r = &rows[4*iq2];
+        if (nq2 < 4) { // linear fallback, as in LogBicubicInterpolator
+          r[0] = grid.xf(ix, iq2);
+          r[1] = grid.xf(ix+1, iq2) - grid.xf(ix, iq2);
+          r[2] = r[3] = 0;
+        } else {
+          _hermiteCoeffs(grid.xf(ix, iq2), _dxf_dlogx(grid, s, ix, iq2) * dlogx_1,
+                         grid.xf(ix+1, iq2), _dxf_dlogx(grid, s, ix+1, iq2) * dlogx_1, r);
+        }
+      }
+
+      // Combine the rows into the bicubic coefficients of each cell
+      const size_t iq2max = nq2 - 1;
+      for (size_t iq2 = 0; iq2 < iq2max; ++iq2) {
+        double* c = &coeffs[16*(ix*iq2max + iq2)];
+        const double* rl = &rows[4*iq2];
+        const double* rh = &rows[4*(iq2+1)];
+        if (nq2 < 4) {
+          for (size_t a = 0; a < 4; ++a) {
+            c[a] = rl[a];
+            c[4+a] = rh[a] - rl[a];
+          }
+          continue;
+        }
+        const double dlogq_0 = (iq2 != 0) ? logq2s[iq2] - logq2s[iq2-1] : -1;
+        const double dlogq_1 = logq2s[iq2+1] - logq2s[iq2];
+        const double dlogq_2 = (iq2+1 != iq2max) ? logq2s[iq2+2] - logq2s[iq2+1] : -1;
+        for (size_t a = 0; a < 4; ++a) {
+          // Q2 derivatives of each t_x coefficient, as in LogBicubicInterpolator::interpolateStencil
+          const double vl = rl[a], vh = rh[a];
+          double vdl, vdh;
+          if (iq2 > 0 && iq2+1 < iq2max) {
+            const double vll = rows[4*(iq2-1) + a];
+            const double vhh = rows[4*(iq2+2) + a];
+            vdl = ( (vh - vl)/dlogq_1 + (vl - vll)/dlogq_0 ) / 2.0;
+            vdh = ( (vh - vl)/dlogq_1 + (vhh - vh)/dlogq_2 ) / 2.0;
+          } else if (iq2 == 0) {
+            const double vhh = rows[4*(iq2+2) + a];
+            vdl = (vh - vl) / dlogq_1;
+            vdh = (vdl + (vhh - vh)/dlogq_2) / 2.0;
+          } else {
+            const double vll = rows[4*(iq2-1) + a];
+            vdh = (vh - vl) / dlogq_1;
+            vdl = (vdh + (vl - vll)/dlogq_0) / 2.0;
+          }
+          double k[4];
+          _hermiteCoeffs(vl, vdl*dlogq_1, vh, vdh*dlogq_1, k);
+          for (size_t b = 0; b < 4; ++b) c[4*b + a] = k[b];
+        }
+      }
+    }
+  }
+
+
+  void LogBicubicCoeffInterpolator::_buildCoeffs() const {
+    // Generations count from 1, so an unbuilt table never matches
+    const size_t generation = pdf().gridGeneration();
+    if (_coeffsgeneration.load(std::memory_order_acquire) == generation) return;
+    std::lock_guard<std::mutex> lock(_coeffsmutex);
+    if (_coeffsgeneration.load(std::memory_order_acquire) == generation) return; //< already done by another thread
+    // Tables keyed by the grids of an earlier generation may be stale, or their keys reused
+    _coefftables.clear();
+    for (const pair<const double, KnotArrayNF>& q2_ka : pdf().knotarrays()) {
+      for (int pid : pdf().flavors()) {
+        const KnotArray1F* g = q2_ka.second.find_pid(pid);
+        if (g != nullptr) _updateCoeffs(*g, _coefftables[g]); //< aliases share a table
+      }
+    }
+    _coeffsgeneration.store(generation, std::memory_order_release);
+  }
+
+
+  void LogBicubicCoeffInterpolator::_updateCoeffs(const KnotArray1F& grid, CoeffTable& table) {
+    const uint64_t version = grid.version();
+    if (table.version.load(std::memory_order_acquire) == version) return;
+    _computeCoeffs(grid, table.coeffs);
+    table.version.store(version, std::memory_order_release);
+  }
+
+
+  const double* LogBicubicCoeffInterpolator::_coeffs(const KnotArray1F& grid) const {
+    _buildCoeffs();
+    std::unordered_map<const KnotArray1F*, CoeffTable>::iterator it = _coefftables.find(&grid);
+    if (it == _coefftables.end())
+      throw GridError("No interpolation coefficients found for a grid not belonging to the bound PDF");
+    // The grid's values may have been changed since its table was computed, without a new grid generation
+    CoeffTable& table = it->second;
+    if (table.version.load(std::memory_order_acquire) != grid.version()) {
+      std::lock_guard<std::mutex> lock(_coeffsmutex);
+      _updateCoeffs(grid, table);
+    }
+    return table.coeffs.data();
+  }
+
+
+  double LogBicubicCoeffInterpolator::_interpolateXQ2(const KnotArray1F& subgrid, double x, size_t ix, double q2, size_t iq2) const {
+    Stencil s;
+    _fillCachedStencil(s, *subgrid.geometry(), x, ix, q2, iq2);
+    return _evalCell(_coeffs(subgrid), s);
+  }
+
+
+  void LogBicubicCoeffInterpolator::_interpolateXQ2(const KnotArrayNF& subgrid, double x, size_t ix, double q2, size_t iq2,
+                                                    const int* ids, double* out, size_t nids) const {
+    const KnotGeometry& geom = *subgrid.get_first().geometry();
+    Stencil s;
+    _fillCachedStencil(s, geom, x, ix, q2, iq2);
+    for (size_t i = 0; i < nids; ++i) {
+      const KnotArray1F* grid = subgrid.find_pid(ids[i]);
+      if (grid == nullptr) {
+        out[i] = 0;
+      } else if (subgrid.has_aliases() && _reuseAliased(subgrid, grid, ids, out, i)) {
+        continue;
+      } else if (grid->geometry().get() == &geom) {
+        out[i] = _evalCell(_coeffs(*grid), s);
+      } else { // a hand-filled grid may have different knots for each flavor
+        out[i] = _interpolateXQ2(*grid, x, grid->ixbelow(x), q2, grid->iq2below(q2));
+      }
+    }
+  }
+
+
+  void LogBicubicCoeffInterpolator::_interpolateXQ2(int id, const double* xs, const double* q2s, double* out, size_t n) const {
+    // Runs of points in the same subgrid share its table lookup and grid checks, done by
+    // the full stencil fill of each run's first point: the rest only need the cell fractions
+    const KnotArray1F* grid = nullptr;
+    const double* coeffs = nullptr;
+    Stencil s;
+    for (size_t i = 0; i < n; ++i) {
+      const KnotArray1F& subgrid = pdf().subgrid(id, q2s[i]);
+      const size_t ix = subgrid.ixbelow(xs[i]), iq2 = subgrid.iq2below(q2s[i]);
+      if (&subgrid != grid) {
+        grid = &subgrid;
+        coeffs = _coeffs(subgrid);
+        fillStencil(s, *subgrid.geometry(), xs[i], ix, q2s[i], iq2);
+      } else {
+        s.ix = ix;
+        s.iq2 = iq2;
+        s.tlogx = (log(xs[i]) - s.logxs[ix]) / (s.logxs[ix+1] - s.logxs[ix]);
+        s.tlogq = (log(q2s[i]) - s.logq2s[iq2]) / (s.logq2s[iq2+1] - s.logq2s[iq2]);
+      }
+      out[i] = _evalCell(coeffs, s);
+    }
+  }
+
+}
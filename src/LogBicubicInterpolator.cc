@@ -4,160 +4,319 @@
 // Copyright (C) 2012-2019 The LHAPDF collaboration (see AUTHORS for details)
 //
 #include "LHAPDF/LogBicubicInterpolator.h"
+#include "LHAPDF/GridPDF.h"
 #include <iostream>
+#include <limits>
 
 namespace LHAPDF {
 
 
   namespace { // Unnamed namespace
 
-    /// One-dimensional linear interpolation for y(x)
-    inline double _interpolateLinear(double x, double xl, double xh, double yl, double yh)	{
-      assert(x >= xl);
-      assert(xh >= x);
-      return yl + (x - xl) / (xh - xl) * (yh - yl);
-    }
+    /// Number of points per block in the batched interpolation kernel
+    const size_t BLOCKSIZE = 32;
 
-    /// One-dimensional cubic interpolation
-    inline double _interpolateCubic(double T, double VL, double VDL, double VH, double VDH) {
-      // Pre-calculate powers of T
-      const double t2 = T*T;
-      const double t3 = t2*T;
+    /// Maximum number of flavors gathered from interleaved storage on the stack
+    const size_t MAXGATHERFLAVS = 32;
 
-      // Calculate left point
-      const double p0 = (2*t3 - 3*t2 + 1)*VL;
-      const double m0 = (t3 - 2*t2 + T)*VDL;
+    /// The 4x4 knot neighbourhood of one flavor, gathered from interleaved storage
+    struct KnotBlock {
+      const double* f; //< 16 values, row-major in Q2
+      size_t ix0, iq20; //< indices of the lowest knots
+      double xf(size_t ix, size_t iq2) const { return f[4*(iq2 - iq20) + (ix - ix0)]; }
+    };
 
-      // Calculate right point
-      const double p1 = (-2*t3 + 3*t2)*VH;
-      const double m1 = (t3 - t2)*VDH;
+    /// Check that the grid is large enough, and the x and q index ranges valid for interpolation
+    void _checkGridSize(size_t nxknots, size_t nq2knots, size_t ix, size_t iq2) {
+      // Raise an error if there are too few knots even for a linear fall-back
+      if (nxknots < 4)
+        throw GridError("PDF subgrids are required to have at least 4 x-knots for use with LogBicubicInterpolator");
+      if (nq2knots < 2)
+        throw GridError("PDF subgrids are required to have at least 2 Q-knots for use with LogBicubicInterpolator");
 
-      return p0 + m0 + p1 + m1;
+      // Check x and q index ranges -- we always need i and i+1 indices to be valid
+      const size_t ixmax = nxknots - 1;
+      const size_t iq2max = nq2knots - 1;
+      if (ix+1 > ixmax) // also true if ix is off the end
+        throw GridError("Attempting to access an x-knot index past the end of the array, in linear fallback mode");
+      if (iq2+1 > iq2max) // also true if iq2 is off the end
+        throw GridError("Attempting to access an Q-knot index past the end of the array, in linear fallback mode");
     }
 
 
-    /// Calculate adjacent d(xf)/dx at all grid locations for fixed iq2
+    /// @brief Add the weights of the knots around knot @a i in d(f)/d(log k) to @a w, scaled by @a c
     ///
-    /// @todo Store pre-cached dlogxs, dlogq2s on subgrids, to replace these denominators? Any real speed gain for the extra memory?
-    double _dxf_dlogx(const KnotArray1F& subgrid, size_t ix, size_t iq2) {
-      const size_t nxknots = subgrid.xs().size();
-      if (ix != 0 && ix != nxknots-1) { //< If central, use the central difference
-        /// @note We evaluate the most likely condition first to help compiler branch prediction
-        const double lddx = (subgrid.xf(ix, iq2) - subgrid.xf(ix-1, iq2)) / (subgrid.logxs()[ix] - subgrid.logxs()[ix-1]);
-        const double rddx = (subgrid.xf(ix+1, iq2) - subgrid.xf(ix, iq2)) / (subgrid.logxs()[ix+1] - subgrid.logxs()[ix]);
-        return (lddx + rddx) / 2.0;
-      } else if (ix == 0) { //< If at leftmost edge, use forward difference
-        return (subgrid.xf(ix+1, iq2) - subgrid.xf(ix, iq2)) / (subgrid.logxs()[ix+1] - subgrid.logxs()[ix]);
-      } else if (ix == nxknots-1) { //< If at rightmost edge, use backward difference
-        return (subgrid.xf(ix, iq2) - subgrid.xf(ix-1, iq2)) / (subgrid.logxs()[ix] - subgrid.logxs()[ix-1]);
+    /// The finite differences are those of _dxf_dlogx: central, or one-sided at the ends.
+    void _addDerivativeWeights(const vector<double>& logks, size_t i, double c, size_t i0, double* w) {
+      if (i != 0 && i+1 != logks.size()) {
+        const double dl = logks[i] - logks[i-1];
+        const double dr = logks[i+1] - logks[i];
+        w[i-1-i0] -= c/dl/2.0;
+        w[i-i0] += c/dl/2.0 - c/dr/2.0;
+        w[i+1-i0] += c/dr/2.0;
+      } else if (i == 0) {
+        const double d = logks[1] - logks[0];
+        w[0-i0] -= c/d;
+        w[1-i0] += c/d;
       } else {
-        throw LogicError("We shouldn't be able to get here!");
+        const double d = logks[i] - logks[i-1];
+        w[i-1-i0] -= c/d;
+        w[i-i0] += c/d;
+      }
+    }
+
+    /// @brief Fill the weights of the knots for interpolation at @a logk in the knot interval [ik, ik+1]
+    ///
+    /// Hermite-cubic with finite-difference derivatives at both ends of the
+    /// interval, as in interpolateStencil, or else linear.
+    void _axisWeights(const vector<double>& logks, size_t ik, double logk, bool cubic, Interpolator::AxisWeights& aw) {
+      const double d1 = logks[ik+1] - logks[ik];
+      const double t = (logk - logks[ik]) / d1;
+      if (!cubic) {
+        aw.i0 = ik;
+        aw.n = 2;
+        aw.w[0] = 1 - t;
+        aw.w[1] = t;
+        return;
       }
+      aw.i0 = (ik > 0) ? ik-1 : ik;
+      aw.n = std::min(ik+2, logks.size()-1) - aw.i0 + 1;
+      std::fill(aw.w, aw.w+4, 0.0);
+      const double t2 = t*t, t3 = t2*t;
+      aw.w[ik-aw.i0] += 2*t3 - 3*t2 + 1;
+      aw.w[ik+1-aw.i0] += -2*t3 + 3*t2;
+      _addDerivativeWeights(logks, ik, (t3 - 2*t2 + t)*d1, aw.i0, aw.w);
+      _addDerivativeWeights(logks, ik+1, (t3 - t2)*d1, aw.i0, aw.w);
     }
 
   }
 
 
-  double LogBicubicInterpolator::_interpolateXQ2(const KnotArray1F& subgrid, double x, size_t ix, double q2, size_t iq2) const {
-    // Raise an error if there are too few knots even for a linear fall-back
-    const size_t nxknots = subgrid.logxs().size();
-    const size_t nq2knots = subgrid.logq2s().size();
-    if (nxknots < 4)
-      throw GridError("PDF subgrids are required to have at least 4 x-knots for use with LogBicubicInterpolator");
-    if (nq2knots < 2)
-      throw GridError("PDF subgrids are required to have at least 2 Q-knots for use with LogBicubicInterpolator");
-
-    // Check x and q index ranges -- we always need i and i+1 indices to be valid
-    const size_t ixmax = nxknots - 1;
-    const size_t iq2max = nq2knots - 1;
-    if (ix+1 > ixmax) // also true if ix is off the end
-      throw GridError("Attempting to access an x-knot index past the end of the array, in linear fallback mode");
-    if (iq2+1 > iq2max) // also true if iq2 is off the end
-      throw GridError("Attempting to access an Q-knot index past the end of the array, in linear fallback mode");
-
-    // Update the cache: separately for x and Q since they can be varied very differently
+  LogBicubicInterpolator::XQ2Cache& LogBicubicInterpolator::_getCache() {
+    thread_local XQ2Cache cache;
+    return cache;
+  }
+
+
+  void LogBicubicInterpolator::fillStencil(Stencil& s, const KnotGeometry& geom, double x, size_t ix, double q2, size_t iq2) {
+    const vector<double>& logxs = geom.logxs();
+    const vector<double>& logq2s = geom.logq2s();
+    s.nxknots = logxs.size();
+    s.nq2knots = logq2s.size();
+    _checkGridSize(s.nxknots, s.nq2knots, ix, iq2);
+    const size_t iq2max = s.nq2knots - 1;
+
+    s.ix = ix;
+    s.iq2 = iq2;
+    s.logxs = &logxs[0];
+    s.logq2s = &logq2s[0];
+    s.logx = log(x);
+    s.logq2 = log(q2);
+    s.dlogx_1 = logxs[ix+1] - logxs[ix];
+    s.tlogx = (s.logx - logxs[ix]) / s.dlogx_1;
+    s.dlogq_0 = (iq2 != 0) ? logq2s[iq2] - logq2s[iq2-1] : -1; //< Don't evaluate (or use) if iq2-1 < 0
+    s.dlogq_1 = logq2s[iq2+1] - logq2s[iq2];
+    s.dlogq_2 = (iq2+1 != iq2max) ? logq2s[iq2+2] - logq2s[iq2+1] : -1; //< Don't evaluate (or use) if iq2+2 > iq2max
+    s.tlogq = (s.logq2 - logq2s[iq2]) / s.dlogq_1;
+  }
+
+
+  void LogBicubicInterpolator::_fillCachedStencil(Stencil& s, const KnotGeometry& geom, double x, size_t ix, double q2, size_t iq2) const {
+    const vector<double>& logxs = geom.logxs();
+    const vector<double>& logq2s = geom.logq2s();
+    s.nxknots = logxs.size();
+    s.nq2knots = logq2s.size();
+    _checkGridSize(s.nxknots, s.nq2knots, ix, iq2);
+    const size_t iq2max = s.nq2knots - 1;
+    s.ix = ix;
+    s.iq2 = iq2;
+    s.logxs = &logxs[0];
+    s.logq2s = &logq2s[0];
+
+    // Look up the x and Q2 params separately, since they can be varied very differently
     /// @todo Fuzzy testing?
-    /// @todo Safety against simultaneous, interleaved use of multiple PDFs?!?
-    ///       Test of 'this'? But would like to re-use across PDF variations with compatible grids...
-    ///       How about the GridPDF/KnotArray1F contains hashes of its knot positions, precomputed at init time, and we compare those for cache validation?
-    bool xixok = true;
-    if (_getCache().x != x) { _getCache().logx = log(x); xixok = false; }
-    if (_getCache().ix != ix) { _getCache().dlogx_1 = subgrid.logxs()[ix+1] - subgrid.logxs()[ix]; xixok = false; }
-    if (!xixok) _getCache().tlogx = (_getCache().logx - subgrid.logxs()[ix]) / _getCache().dlogx_1;
-    bool qiqok = true;
-    if (_getCache().q2 != q2) { _getCache().logq2 = log(q2); qiqok = false; }
-    if (_getCache().iq2 != iq2) {
-      _getCache().dlogq_0 = (iq2 != 0) ? subgrid.logq2s()[iq2] - subgrid.logq2s()[iq2-1] : -1; //< Don't evaluate (or use) if iq2-1 < 0
-      _getCache().dlogq_1 = subgrid.logq2s()[iq2+1] - subgrid.logq2s()[iq2];
-      _getCache().dlogq_2 = (iq2+1 != iq2max) ? subgrid.logq2s()[iq2+2] - subgrid.logq2s()[iq2+1] : -1; //< Don't evaluate (or use) if iq2+2 > iq2max
-      qiqok = false;
+    const size_t hash = geom.hash();
+    XQ2Cache& cache = _getCache();
+
+    const XCacheEntry* xentry = nullptr;
+    for (const XCacheEntry& e : cache.xentries) {
+      if (e.x == x && e.ix == ix && e.geom == &geom && e.hash == hash) { xentry = &e; break; }
     }
-    if (!qiqok) _getCache().tlogq = (_getCache().logq2 - subgrid.logq2s()[iq2]) / _getCache().dlogq_1;
-    const double logx = _getCache().logx;
-    const double logq2 = _getCache().logq2;
-
-    // Fall back to LogBilinearInterpolator if either 2 or 3 Q-knots
-    if (nq2knots < 4) {
-      // First interpolate in x
-      const double logx0 = subgrid.logxs()[ix];
-      const double logx1 = subgrid.logxs()[ix+1];
-      const double f_ql = _interpolateLinear(logx, logx0, logx1, subgrid.xf(ix, iq2), subgrid.xf(ix+1, iq2));
-      const double f_qh = _interpolateLinear(logx, logx0, logx1, subgrid.xf(ix, iq2+1), subgrid.xf(ix+1, iq2+1));
-      // Then interpolate in Q2, using the x-ipol results as anchor points
-      return _interpolateLinear(logq2, subgrid.logq2s()[iq2], subgrid.logq2s()[iq2+1], f_ql, f_qh);
+    if (xentry == nullptr) {
+      XCacheEntry& e = cache.xentries[cache.nextx];
+      cache.nextx = (cache.nextx + 1) % NCACHE;
+      e.geom = &geom;
+      e.hash = hash;
+      e.x = x;
+      e.ix = ix;
+      e.logx = log(x);
+      e.dlogx_1 = logxs[ix+1] - logxs[ix];
+      e.tlogx = (e.logx - logxs[ix]) / e.dlogx_1;
+      xentry = &e;
     }
-    // else proceed with cubic interpolation:
+    s.logx = xentry->logx;
+    s.dlogx_1 = xentry->dlogx_1;
+    s.tlogx = xentry->tlogx;
+
+    const Q2CacheEntry* q2entry = nullptr;
+    for (const Q2CacheEntry& e : cache.q2entries) {
+      if (e.q2 == q2 && e.iq2 == iq2 && e.geom == &geom && e.hash == hash) { q2entry = &e; break; }
+    }
+    if (q2entry == nullptr) {
+      Q2CacheEntry& e = cache.q2entries[cache.nextq2];
+      cache.nextq2 = (cache.nextq2 + 1) % NCACHE;
+      e.geom = &geom;
+      e.hash = hash;
+      e.q2 = q2;
+      e.iq2 = iq2;
+      e.logq2 = log(q2);
+      e.dlogq_0 = (iq2 != 0) ? logq2s[iq2] - logq2s[iq2-1] : -1; //< Don't evaluate (or use) if iq2-1 < 0
+      e.dlogq_1 = logq2s[iq2+1] - logq2s[iq2];
+      e.dlogq_2 = (iq2+1 != iq2max) ? logq2s[iq2+2] - logq2s[iq2+1] : -1; //< Don't evaluate (or use) if iq2+2 > iq2max
+      e.tlogq = (e.logq2 - logq2s[iq2]) / e.dlogq_1;
+      q2entry = &e;
+    }
+    s.logq2 = q2entry->logq2;
+    s.dlogq_0 = q2entry->dlogq_0;
+    s.dlogq_1 = q2entry->dlogq_1;
+    s.dlogq_2 = q2entry->dlogq_2;
+    s.tlogq = q2entry->tlogq;
+  }
 
-    // Pre-calculate parameters
-    /// @todo Cache these between calls, re-using if x == x_prev and Q2 == Q2_prev
-    const double dlogx_1 = _getCache().dlogx_1;
-    const double tlogx = _getCache().tlogx;
-    const double dlogq_0 = _getCache().dlogq_0; //< Don't evaluate (or use) if iq2-1 < 0
-    const double dlogq_1 = _getCache().dlogq_1;
-    const double dlogq_2 = _getCache().dlogq_2; //< Don't evaluate (or use) if iq2+2 > iq2max
-    const double tlogq = _getCache().tlogq;
 
+  double LogBicubicInterpolator::_interpolateXQ2(const KnotArray1F& subgrid, double x, size_t ix, double q2, size_t iq2) const {
+    Stencil s;
+    _fillCachedStencil(s, *subgrid.geometry(), x, ix, q2, iq2);
     /// @todo Statically pre-compute the whole nx * nq gradiant array? I.e. _dxf_dlogx for all points in all subgrids. Memory ~doubling :-/ Could cache them as they are used...
+    return interpolateStencil(subgrid, s);
+  }
 
-    // Points in Q2
-    double vl = _interpolateCubic(tlogx, subgrid.xf(ix, iq2), _dxf_dlogx(subgrid, ix, iq2) * dlogx_1,
-                                         subgrid.xf(ix+1, iq2), _dxf_dlogx(subgrid, ix+1, iq2) * dlogx_1);
-    double vh = _interpolateCubic(tlogx, subgrid.xf(ix, iq2+1), _dxf_dlogx(subgrid, ix, iq2+1) * dlogx_1,
-                                         subgrid.xf(ix+1, iq2+1), _dxf_dlogx(subgrid, ix+1, iq2+1) * dlogx_1);
-
-    // Derivatives in Q2
-    double vdl, vdh;
-    if (iq2 > 0 && iq2+1 < iq2max) {
-      // Central difference for both q
-      /// @note We evaluate the most likely condition first to help compiler branch prediction
-      double vll = _interpolateCubic(tlogx, subgrid.xf(ix, iq2-1), _dxf_dlogx(subgrid, ix, iq2-1) * dlogx_1,
-                                            subgrid.xf(ix+1, iq2-1), _dxf_dlogx(subgrid, ix+1, iq2-1) * dlogx_1);
-      vdl = ( (vh - vl)/dlogq_1 + (vl - vll)/dlogq_0 ) / 2.0;
-      double vhh = _interpolateCubic(tlogx, subgrid.xf(ix, iq2+2), _dxf_dlogx(subgrid, ix, iq2+2) * dlogx_1,
-                                            subgrid.xf(ix+1, iq2+2), _dxf_dlogx(subgrid, ix+1, iq2+2) * dlogx_1);
-      vdh = ( (vh - vl)/dlogq_1 + (vhh - vh)/dlogq_2 ) / 2.0;
-    }
-    else if (iq2 == 0) {
-      // Forward difference for lower q
-      vdl = (vh - vl) / dlogq_1;
-      // Central difference for higher q
-      double vhh = _interpolateCubic(tlogx, subgrid.xf(ix, iq2+2), _dxf_dlogx(subgrid, ix, iq2+2) * dlogx_1,
-                                            subgrid.xf(ix+1, iq2+2), _dxf_dlogx(subgrid, ix+1, iq2+2) * dlogx_1);
-      vdh = (vdl + (vhh - vh)/dlogq_2) / 2.0;
+
+  void LogBicubicInterpolator::_interpolateXQ2(const KnotArrayNF& subgrid, double x, size_t ix, double q2, size_t iq2,
+                                               const int* ids, double* out, size_t nids) const {
+    // Compute the indices and weights once, for all the flavors which share the subgrid knots
+    const KnotGeometry& geom = *subgrid.get_first().geometry();
+    Stencil s;
+    _fillCachedStencil(s, geom, x, ix, q2, iq2);
+
+    // With interleaved storage, gather the 4x4 neighbourhood of all flavors at once
+    // from 16 contiguous runs, for points needing no one-sided derivatives
+    const size_t nflavs = subgrid.pids().size();
+    if (subgrid.interleaved() && nflavs <= MAXGATHERFLAVS &&
+        s.ix > 0 && s.ix+2 < s.nxknots && s.iq2 > 0 && s.iq2+2 < s.nq2knots) {
+      double f[MAXGATHERFLAVS*16];
+      for (size_t jq = 0; jq < 4; ++jq) {
+        for (size_t jx = 0; jx < 4; ++jx) {
+          const double* xfs = subgrid.xfs(s.ix-1 + jx, s.iq2-1 + jq);
+          for (size_t k = 0; k < nflavs; ++k) f[16*k + 4*jq + jx] = xfs[k];
+        }
+      }
+      for (size_t i = 0; i < nids; ++i) {
+        const int iflav = subgrid.flavorIndex(ids[i]);
+        out[i] = (iflav < 0) ? 0.0 : interpolateStencil(KnotBlock{f + 16*iflav, s.ix-1, s.iq2-1}, s);
+      }
+      return;
     }
-    else if (iq2+1 == iq2max) {
-      // Backward difference for higher q
-      vdh = (vh - vl) / dlogq_1;
-      // Central difference for lower q
-      double vll = _interpolateCubic(tlogx, subgrid.xf(ix, iq2-1), _dxf_dlogx(subgrid, ix, iq2-1) * dlogx_1,
-                                            subgrid.xf(ix+1, iq2-1), _dxf_dlogx(subgrid, ix+1, iq2-1) * dlogx_1);
-      vdl = (vdh + (vl - vll)/dlogq_0) / 2.0;
+
+    for (size_t i = 0; i < nids; ++i) {
+      const KnotArray1F* grid = subgrid.find_pid(ids[i]);
+      if (grid == nullptr) {
+        out[i] = 0;
+      } else if (subgrid.has_aliases() && _reuseAliased(subgrid, grid, ids, out, i)) {
+        continue;
+      } else if (grid->geometry().get() == &geom) {
+        out[i] = interpolateStencil(*grid, s);
+      } else { // a hand-filled grid may have different knots for each flavor
+        out[i] = _interpolateXQ2(*grid, x, grid->ixbelow(x), q2, grid->iq2below(q2));
+      }
     }
-    else throw LogicError("We shouldn't be able to get here!");
+  }
+
+
+  bool LogBicubicInterpolator::_xWeights(const KnotGeometry& geom, double x, AxisWeights& aw) const {
+    const size_t ix = geom.ixbelow(x);
+    _checkGridSize(geom.xs().size(), geom.q2s().size(), ix, 0);
+    // Linear in x as well as Q2 if there are too few Q2 knots for the cubic
+    _axisWeights(geom.logxs(), ix, log(x), geom.q2s().size() >= 4, aw);
+    return true;
+  }
+
 
-    vdl *= dlogq_1;
-    vdh *= dlogq_1;
-    return _interpolateCubic(tlogq, vl, vdl, vh, vdh);
+  bool LogBicubicInterpolator::_q2Weights(const KnotGeometry& geom, double q2, AxisWeights& aw) const {
+    const size_t iq2 = geom.iq2below(q2);
+    _checkGridSize(geom.xs().size(), geom.q2s().size(), 0, iq2);
+    _axisWeights(geom.logq2s(), iq2, log(q2), geom.q2s().size() >= 4, aw);
+    return true;
+  }
+
+
+  void LogBicubicInterpolator::_interpolateXQ2(int id, const double* xs, const double* q2s, double* out, size_t n) const {
+    // Block arrays of gathered knot values (4x4 per point, row-major in Q2) and stencil params
+    double f[16][BLOCKSIZE];
+    double dlogx_0[BLOCKSIZE], dlogx_1[BLOCKSIZE], dlogx_2[BLOCKSIZE], tlogx[BLOCKSIZE];
+    double dlogq_0[BLOCKSIZE], dlogq_1[BLOCKSIZE], dlogq_2[BLOCKSIZE], tlogq[BLOCKSIZE];
+    double rtn[BLOCKSIZE];
+    size_t ipts[BLOCKSIZE];
+
+    // The current subgrid, reused while successive points stay within its [q2lo, q2hi) range
+    const map<double, KnotArrayNF>& subgrids = pdf().knotarrays();
+    const KnotArray1F* subgridptr = nullptr;
+    double q2lo = 0, q2hi = 0;
+
+    Stencil s;
+    for (size_t i0 = 0; i0 < n; i0 += BLOCKSIZE) {
+      const size_t i1 = std::min(n, i0 + BLOCKSIZE);
+
+      // Compute the stencils, and gather the interior points
+      size_t nb = 0;
+      for (size_t i = i0; i < i1; ++i) {
+        if (subgridptr == nullptr || q2s[i] < q2lo || q2s[i] >= q2hi) {
+          map<double, KnotArrayNF>::const_iterator it = subgrids.upper_bound(q2s[i]);
+          q2hi = (it != subgrids.end()) ? it->first : std::numeric_limits<double>::infinity();
+          if (it == subgrids.begin()) {
+            pdf().subgrid(q2s[i]); //< throws the appropriate error
+            throw LogicError("We shouldn't be able to get here!");
+          }
+          --it;
+          q2lo = it->first;
+          subgridptr = &it->second.get_pid(id);
+        }
+        const KnotArray1F& subgrid = *subgridptr;
+        fillStencil(s, *subgrid.geometry(), xs[i], subgrid.ixbelow(xs[i]), q2s[i], subgrid.iq2below(q2s[i]));
+        const bool interior = s.nq2knots >= 4 && s.ix > 0 && s.ix+2 < s.nxknots && s.iq2 > 0 && s.iq2+2 < s.nq2knots;
+        if (!interior) {
+          out[i] = interpolateStencil(subgrid, s);
+          continue;
+        }
+        for (size_t jq = 0; jq < 4; ++jq)
+          for (size_t jx = 0; jx < 4; ++jx)
+            f[4*jq + jx][nb] = subgrid.xf(s.ix-1 + jx, s.iq2-1 + jq);
+        dlogx_0[nb] = s.logxs[s.ix] - s.logxs[s.ix-1];
+        dlogx_1[nb] = s.dlogx_1;
+        dlogx_2[nb] = s.logxs[s.ix+2] - s.logxs[s.ix+1];
+        tlogx[nb] = s.tlogx;
+        dlogq_0[nb] = s.dlogq_0;
+        dlogq_1[nb] = s.dlogq_1;
+        dlogq_2[nb] = s.dlogq_2;
+        tlogq[nb] = s.tlogq;
+        ipts[nb] = i;
+        nb += 1;
+      }
+
+      // Branch-free bicubic kernel across the gathered points, as in interpolateStencil
+      for (size_t k = 0; k < nb; ++k) {
+        const double vll = _interpolateCubicRow(f[0][k], f[1][k], f[2][k], f[3][k], dlogx_0[k], dlogx_1[k], dlogx_2[k], tlogx[k]);
+        const double vl = _interpolateCubicRow(f[4][k], f[5][k], f[6][k], f[7][k], dlogx_0[k], dlogx_1[k], dlogx_2[k], tlogx[k]);
+        const double vh = _interpolateCubicRow(f[8][k], f[9][k], f[10][k], f[11][k], dlogx_0[k], dlogx_1[k], dlogx_2[k], tlogx[k]);
+        const double vhh = _interpolateCubicRow(f[12][k], f[13][k], f[14][k], f[15][k], dlogx_0[k], dlogx_1[k], dlogx_2[k], tlogx[k]);
+        double vdl = ( (vh - vl)/dlogq_1[k] + (vl - vll)/dlogq_0[k] ) / 2.0;
+        double vdh = ( (vh - vl)/dlogq_1[k] + (vhh - vh)/dlogq_2[k] ) / 2.0;
+        vdl *= dlogq_1[k];
+        vdh *= dlogq_1[k];
+        rtn[k] = _interpolateCubic(tlogq[k], vl, vdl, vh, vdh);
+      }
+      for (size_t k = 0; k < nb; ++k) out[ipts[k]] = rtn[k];
+    }
   }
 
 
@@ -0,0 +1,141 @@
+// -*- C++ -*-
+//
+// This file is part of LHAPDF
+// Copyright (C) 2012-2019 The LHAPDF collaboration (see AUTHORS for details)
+//
+#pragma once
+#ifndef LHAPDF_NumScanner_H
+#define LHAPDF_NumScanner_H
+
+// Internal header, not installed: used by the grid data parser and its tests
+
+#include <cstdlib>
+#include <cstdint>
+#if __cplusplus >= 201703L
+#include <charconv>
+#endif
+
+// Use the standard correctly-rounded float parser if available, else our own fast path
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#define LHAPDF_FROM_CHARS 1
+#else
+#define LHAPDF_FROM_CHARS 0
+#endif
+
+namespace LHAPDF {
+
+
+  /// @brief A scanner for the whitespace-separated numbers of a data line
+  ///
+  /// The line is held in place in a NUL-terminated buffer. Numbers are parsed
+  /// without copying or allocation, and with the same correctly-rounded
+  /// results as std::strtod: by std::from_chars if @a FROMCHARS is set (and
+  /// it is available), or else by Clinger's fast path, with the cases which
+  /// neither can handle falling back to std::strtod.
+  template <bool FROMCHARS=LHAPDF_FROM_CHARS>
+  class NumScanner {
+  public:
+
+    /// Constructor from the line start and end pointers
+    NumScanner(const char* begin, const char* end) : _next(begin), _end(end) {}
+
+    /// Read the next number into @a x, returning false if there is none or it is malformed
+    bool next(double& x) {
+      if (!_skipSpace()) return false;
+      const char* start = _next + ((*_next == '+') ? 1 : 0); //< from_chars and _parseFast don't accept a leading +
+      if (start == _end || (*start == '-' && start != _next)) return false;
+      if (FROMCHARS ? _parseFromChars(start, x) : _parseFast(start, x)) return true;
+      // Fall back to strtod for the rare awkward cases, e.g. overflow and underflow
+      char* endptr;
+      x = std::strtod(_next, &endptr);
+      if (endptr == _next || endptr > _end) return false;
+      _next = endptr;
+      return true;
+    }
+
+    /// Read the next base-10 integer into @a i, returning false if there is none or it is malformed
+    bool next(int& i) {
+      if (!_skipSpace()) return false;
+      const char* p = _next;
+      const bool neg = (*p == '-');
+      if (*p == '-' || *p == '+') ++p;
+      if (p == _end || !_isDigit(*p)) return false;
+      long n = 0;
+      for (; p != _end && _isDigit(*p); ++p) n = 10*n + (*p - '0');
+      i = neg ? -n : n;
+      _next = p;
+      return true;
+    }
+
+    /// The unread part of the line
+    const char* unread() const { return _next; }
+
+
+  private:
+
+    static bool _isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    /// Skip whitespace as std::strtod does, returning false at the end of the line
+    bool _skipSpace() {
+      while (_next != _end && (*_next == ' ' || *_next == '\t' || *_next == '\r' || *_next == '\v' || *_next == '\f')) ++_next;
+      return _next != _end;
+    }
+
+    /// Parse with std::from_chars, leaving anything it can't handle exactly as strtod would to the fallback
+    bool _parseFromChars(const char* p, double& x) {
+      #if LHAPDF_FROM_CHARS
+      const std::from_chars_result res = std::from_chars(p, _end, x);
+      if (res.ec == std::errc() && (res.ptr == _end || (*res.ptr != 'x' && *res.ptr != 'X'))) { //< strtod also reads hex
+        _next = res.ptr;
+        return true;
+      }
+      #else
+      (void) p; (void) x;
+      #endif
+      return false;
+    }
+
+    /// @brief Clinger's fast path
+    ///
+    /// A decimal mantissa below 2^53 with a power of ten up to 10^22 is
+    /// converted exactly by a single correctly-rounded multiplication or division.
+    bool _parseFast(const char* p, double& x) {
+      static const double POW10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+      const bool neg = (*p == '-');
+      if (neg) ++p;
+      uint64_t mant = 0;
+      int ndigits = 0, exp10 = 0;
+      for (; p != _end && _isDigit(*p); ++p, ++ndigits) mant = 10*mant + (*p - '0');
+      if (p != _end && *p == '.') {
+        for (++p; p != _end && _isDigit(*p); ++p, ++ndigits, --exp10) mant = 10*mant + (*p - '0');
+      }
+      if (ndigits == 0 || ndigits > 19) return false;
+      if (p != _end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        const bool eneg = (q != _end && *q == '-');
+        if (q != _end && (*q == '-' || *q == '+')) ++q;
+        if (q == _end || !_isDigit(*q)) return false;
+        int e = 0;
+        for (; q != _end && _isDigit(*q) && e < 10000; ++q) e = 10*e + (*q - '0');
+        if (q != _end && _isDigit(*q)) return false;
+        exp10 += eneg ? -e : e;
+        p = q;
+      }
+      if (p != _end && (*p == 'x' || *p == 'X')) return false; //< hex, left to strtod
+      if (mant > (uint64_t(1) << 53) || exp10 < -22 || exp10 > 22) return false;
+      const double m = double(mant);
+      x = (exp10 < 0) ? m / POW10[-exp10] : m * POW10[exp10];
+      if (neg) x = -x;
+      _next = p;
+      return true;
+    }
+
+    const char* _next;
+    const char* _end;
+
+  };
+
+
+}
+#endif
@@ -13,8 +13,13 @@ namespace LHAPDF {
   void PDF::_loadInfo(const std::string& mempath) {
     if (mempath.empty())
       throw UserError("Tried to initialize a PDF with a null data file path... oops");
+    _loadInfo(mempath, PDFInfo(mempath));
+  }
+
+
+  void PDF::_loadInfo(const std::string& mempath, const PDFInfo& info) {
     _mempath = mempath;
-    _info = PDFInfo(mempath);
+    _info = info;
     //_info = PDFInfo(_setname(), memberID());
     /// Check that this is a sufficient version LHAPDF for this PDF
     if (_info.has_key("MinLHAPDFVersion")) {
@@ -36,9 +41,21 @@ namespace LHAPDF {
   }
 
 
+  void PDF::freeze() {
+    preload();
+    flavors();
+    forcePositive();
+    if (hasAlphaS()) _alphas->freeze();
+    _frozen = true;
+  }
+
+
   bool PDF::hasFlavor(int id) const {
     const int id2 = (id != 0) ? id : 21; //< @note Treat 0 as an alias for 21
     const vector<int>& ids = flavors();
+    // Standard partons are looked up in the dense mask, unless a derived type supplies its own flavor list
+    const int slot = pidSlot(id2);
+    if (slot >= 0 && &ids == &_flavors) return (_flavormask >> slot) & 1;
     /// @note std::lower_bound is meant to leverage that we have a sorted list. No speed-up over find noted, though
     // return std::find(ids.begin(), ids.end(), id2) != ids.end();
     const auto it = std::lower_bound(ids.begin(), ids.end(), id2);
@@ -73,19 +90,153 @@ namespace LHAPDF {
   }
 
 
+  void PDF::xfxQ2(int id, const double* xs, const double* q2s, double* out, size_t n) const {
+    // Physical range checks, all done before any output is written
+    for (size_t i = 0; i < n; ++i) {
+      if (!inPhysicalRangeX(xs[i])) throw RangeError("Unphysical x given: " + to_str(xs[i]));
+      if (!inPhysicalRangeQ2(q2s[i])) throw RangeError("Unphysical Q2 given: " + to_str(q2s[i]));
+    }
+    // Treat PID = 0 as always equivalent to a gluon: query as PID = 21
+    const int id2 = (id != 0) ? id : 21;
+    // Undefined PIDs
+    if (!hasFlavor(id2)) {
+      std::fill(out, out+n, 0.0);
+      return;
+    }
+    // Call the delegated method in the concrete PDF object to calculate the in-range values
+    _xfxQ2(id2, xs, q2s, out, n);
+    // Apply positivity forcing at the enabled level
+    switch (forcePositive()) {
+    case 0: break;
+    case 1: for (size_t i = 0; i < n; ++i) if (out[i] < 0) out[i] = 0; break;
+    case 2: for (size_t i = 0; i < n; ++i) if (out[i] < 1e-10) out[i] = 1e-10; break;
+    default: throw LogicError("ForcePositive value not in expected range!");
+    }
+  }
+
+
+  void PDF::xfxQ2(int id, const std::vector<double>& xs, const std::vector<double>& q2s, std::vector<double>& rtn) const {
+    if (xs.size() != q2s.size())
+      throw UserError("Batch xfxQ2 called with " + to_str(xs.size()) + " x values but " + to_str(q2s.size()) + " Q2 values");
+    rtn.resize(xs.size());
+    if (!rtn.empty()) xfxQ2(id, &xs[0], &q2s[0], &rtn[0], rtn.size());
+  }
+
+
+  void PDF::_xfxQ2(int id, const double* xs, const double* q2s, double* out, size_t n) const {
+    for (size_t i = 0; i < n; ++i) out[i] = _xfxQ2(id, xs[i], q2s[i]);
+  }
+
+
+  void PDF::xfxQ2(double x, double q2, const int* ids, double* out, size_t nids) const {
+    // Physical range checks
+    if (!inPhysicalRangeX(x)) throw RangeError("Unphysical x given: " + to_str(x));
+    if (!inPhysicalRangeQ2(q2)) throw RangeError("Unphysical Q2 given: " + to_str(q2));
+    // Treat PID = 0 as always equivalent to a gluon, working through the IDs in fixed-size chunks
+    const size_t NCHUNK = 16;
+    int ids2[NCHUNK];
+    for (size_t i0 = 0; i0 < nids; i0 += NCHUNK) {
+      const size_t n = std::min(nids - i0, NCHUNK);
+      for (size_t i = 0; i < n; ++i) ids2[i] = (ids[i0+i] != 0) ? ids[i0+i] : 21;
+      _xfxQ2(x, q2, ids2, out+i0, n);
+    }
+    _forcePositive(ids, out, nids);
+  }
+
+
+  void PDF::xfxQ2(double x, double q2, double* rtn) const {
+    // Physical range checks
+    if (!inPhysicalRangeX(x)) throw RangeError("Unphysical x given: " + to_str(x));
+    if (!inPhysicalRangeQ2(q2)) throw RangeError("Unphysical Q2 given: " + to_str(q2));
+    static const int IDS[13] = {-6, -5, -4, -3, -2, -1, 21, 1, 2, 3, 4, 5, 6};
+    _xfxQ2(x, q2, IDS, rtn, 13);
+    _forcePositive(IDS, rtn, 13);
+  }
+
+
+  void PDF::_xfxQ2(double x, double q2, const int* ids, double* out, size_t nids) const {
+    for (size_t i = 0; i < nids; ++i) out[i] = hasFlavor(ids[i]) ? _xfxQ2(ids[i], x, q2) : 0.0;
+  }
+
+
+  void PDF::_forcePositive(const int* ids, double* xfs, size_t n) const {
+    const int fp = forcePositive();
+    if (fp == 0) return;
+    if (fp != 1 && fp != 2) throw LogicError("ForcePositive value not in expected range!");
+    for (size_t i = 0; i < n; ++i) {
+      if (!hasFlavor(ids[i])) continue; //< undefined PIDs stay at zero, as in the single-flavor xfxQ2
+      if (fp == 1 && xfs[i] < 0) xfs[i] = 0;
+      if (fp == 2 && xfs[i] < 1e-10) xfs[i] = 1e-10;
+    }
+  }
+
+
+  void PDF::tabulate(const vector<double>& xs, const vector<double>& qs, const vector<int>& ids, double* out) const {
+    // Physical range checks, all done before any output is written
+    for (double x : xs)
+      if (!inPhysicalRangeX(x)) throw RangeError("Unphysical x given: " + to_str(x));
+    vector<double> q2s(qs.size());
+    for (size_t i = 0; i < qs.size(); ++i) {
+      q2s[i] = qs[i]*qs[i];
+      if (!inPhysicalRangeQ2(q2s[i])) throw RangeError("Unphysical Q2 given: " + to_str(q2s[i]));
+    }
+    // Treat PID = 0 as always equivalent to a gluon: query as PID = 21
+    vector<int> ids2(ids);
+    for (int& id : ids2) if (id == 0) id = 21;
+    if (ids2.empty() || xs.empty() || qs.empty()) return;
+    _tabulate(xs, q2s, &ids2[0], ids2.size(), out);
+    // Apply positivity forcing at the enabled level, to the defined flavors' tables
+    const size_t ntab = xs.size() * qs.size();
+    for (size_t i = 0; i < ids2.size(); ++i) {
+      if (!hasFlavor(ids2[i])) continue;
+      double* tab = out + i*ntab;
+      switch (forcePositive()) {
+      case 0: break;
+      case 1: for (size_t j = 0; j < ntab; ++j) if (tab[j] < 0) tab[j] = 0; break;
+      case 2: for (size_t j = 0; j < ntab; ++j) if (tab[j] < 1e-10) tab[j] = 1e-10; break;
+      default: throw LogicError("ForcePositive value not in expected range!");
+      }
+    }
+  }
+
+
+  void PDF::tabulate(const vector<double>& xs, const vector<double>& qs, const vector<int>& ids, vector<double>& rtn) const {
+    rtn.resize(ids.size() * xs.size() * qs.size());
+    if (!rtn.empty()) tabulate(xs, qs, ids, &rtn[0]);
+  }
+
+
+  void PDF::_tabulate(const vector<double>& xs, const vector<double>& q2s, const int* ids, size_t nids, double* out) const {
+    const size_t nx = xs.size(), nq2 = q2s.size();
+    vector<double> xfs(nids);
+    for (size_t ix = 0; ix < nx; ++ix) {
+      for (size_t iq2 = 0; iq2 < nq2; ++iq2) {
+        _xfxQ2(xs[ix], q2s[iq2], ids, &xfs[0], nids);
+        for (size_t i = 0; i < nids; ++i) out[(i*nx + ix)*nq2 + iq2] = xfs[i];
+      }
+    }
+  }
+
+
   void PDF::xfxQ2(double x, double q2, std::map<int, double>& rtn) const {
     rtn.clear();
-    for (int id : flavors()) rtn[id] = xfxQ2(id, x, q2);
+    const vector<int>& ids = flavors();
+    // Use a stack buffer for the values, unless there are unusually many flavors
+    double buf[32];
+    vector<double> vbuf;
+    double* xfs = buf;
+    if (ids.size() > 32) {
+      vbuf.resize(ids.size());
+      xfs = &vbuf[0];
+    }
+    if (!ids.empty()) xfxQ2(x, q2, &ids[0], xfs, ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) rtn[ids[i]] = xfs[i];
   }
 
 
   void PDF::xfxQ2(double x, double q2, std::vector<double>& rtn) const {
-    rtn.clear();
     rtn.resize(13);
-    for (int i = 0; i < 13; ++i) {
-      const int id = i-6; // PID = 0 is automatically treated as PID = 21
-      rtn[i] = xfxQ2(id, x, q2);
-    }
+    xfxQ2(x, q2, &rtn[0]);
   }
 
 
@@ -128,20 +279,24 @@ namespace LHAPDF {
   double PDF::quarkMass(int id) const {
     const unsigned int aid = std::abs(id);
     if (aid == 0 || aid > 6) return -1;
-    const static string QNAMES[] = {"Down", "Up", "Strange", "Charm", "Bottom", "Top"}; ///< @todo Centralise?
-    const size_t qid = aid - 1;
-    const string qname = QNAMES[qid];
-    return info().get_entry_as<double>("M" + qname, -1);
+    // Full key names, so that lookups need no string building
+    const static string MKEYS[] = {"MDown", "MUp", "MStrange", "MCharm", "MBottom", "MTop"}; ///< @todo Centralise?
+    return info().get_entry_as<double>(MKEYS[aid-1], -1);
   }
 
 
   double PDF::quarkThreshold(int id) const {
     const unsigned int aid = std::abs(id);
     if (aid == 0 || aid > 6) return -1;
-    const static string QNAMES[] = {"Down", "Up", "Strange", "Charm", "Bottom", "Top"}; ///< @todo Centralise?
-    const size_t qid = aid - 1;
-    const string qname = QNAMES[qid];
-    return info().get_entry_as<double>("Threshold" + qname, quarkMass(id));
+    const static string TKEYS[] = {"ThresholdDown", "ThresholdUp", "ThresholdStrange",
+                                   "ThresholdCharm", "ThresholdBottom", "ThresholdTop"}; ///< @todo Centralise?
+    // Only look up the quark mass if it is needed as the fallback
+    if (info().has_key(TKEYS[aid-1])) {
+      try {
+        return info().get_entry_as<double>(TKEYS[aid-1]);
+      } catch (...) { }
+    }
+    return quarkMass(id);
   }
 
 
@@ -6,29 +6,40 @@
 #include "LHAPDF/PDFInfo.h"
 #include "LHAPDF/PDFSet.h"
 #include "LHAPDF/Factories.h"
+#include "LHAPDF/FileIO.h"
 
 namespace LHAPDF {
 
 
   // Constructor from a path to a member data file.
-  PDFInfo::PDFInfo(const std::string& mempath) {
+  PDFInfo::PDFInfo(const std::string& mempath)
+    : _set(nullptr)
+  {
     if (mempath.empty())
       throw UserError("Empty/invalid data path given to PDFInfo constructor");
     load(mempath);
+    _setSetMember(mempath);
+  }
 
-    // Extract the set name and member ID from the filename.
-    _setname = basename(dirname(mempath));
-    const string memname = file_stem(mempath);
-    assert(memname.length() > 5); // There must be more to the filename stem than just the _nnnn suffix
-    _member = lexical_cast<int>(memname.substr(memname.length()-4)); //< Last 4 chars should be the member number
+
+  // Constructor from the header of an open member data stream.
+  PDFInfo::PDFInfo(std::istream& stream, const std::string& mempath)
+    : _set(nullptr)
+  {
+    if (mempath.empty())
+      throw UserError("Empty/invalid data path given to PDFInfo constructor");
+    load(stream, mempath);
+    _setSetMember(mempath);
   }
 
 
   // Constructor from a set name and member ID.
-  PDFInfo::PDFInfo(const std::string& setname, int member) {
+  PDFInfo::PDFInfo(const std::string& setname, int member)
+    : _set(nullptr)
+  {
     _setname = setname;
     _member = member;
-    const string searchpath = findFile(pdfmempath(setname, member));
+    const string searchpath = findpdfmempath(setname, member);
     if (searchpath.empty())
       throw ReadError("Couldn't find a PDF data file for " + setname + " #" + to_str(member));
     load(searchpath);
@@ -36,7 +47,9 @@ namespace LHAPDF {
 
 
   // Constructor from an LHAPDF ID code.
-  PDFInfo::PDFInfo(int lhaid) {
+  PDFInfo::PDFInfo(int lhaid)
+    : _set(nullptr)
+  {
     const pair<string,int> setname_memid = lookupPDF(lhaid);
     if (setname_memid.second == -1)
       throw IndexError("Can't find a PDF with LHAPDF ID = " + to_str(lhaid));
@@ -48,18 +61,38 @@ namespace LHAPDF {
   }
 
 
+  void PDFInfo::_setSetMember(const std::string& mempath) {
+    // Extract the set name and member ID from the filename.
+    _setname = basename(dirname(mempath));
+    const string memname = file_stem(uncompressedPath(mempath));
+    assert(memname.length() > 5); // There must be more to the filename stem than just the _nnnn suffix
+    _member = lexical_cast<int>(memname.substr(memname.length()-4)); //< Last 4 chars should be the member number
+  }
+
+
+  const PDFSet& PDFInfo::_pdfset() const {
+    const PDFSet* set = _set.load(std::memory_order_acquire);
+    if (set == nullptr) {
+      // getPDFSet returns a stable reference, so racing threads store the same pointer
+      set = &getPDFSet(_setname);
+      _set.store(set, std::memory_order_release);
+    }
+    return *set;
+  }
+
+
   // Overload of Info::has_key() which adds fallback to the PDFSet
   bool PDFInfo::has_key(const string& key) const {
     // cout << key << " in PDF: " << boolalpha << has_key_local(key) << endl;
     // cout << key << " in Set: " << boolalpha << getPDFSet(_setname).has_key(key) << endl;
     // cout << key << " in Cfg: " << boolalpha << getConfig().has_key(key) << endl;
-    return has_key_local(key) || getPDFSet(_setname).has_key(key);
+    return has_key_local(key) || _pdfset().has_key(key);
   }
 
 
   const std::string& PDFInfo::get_entry(const string& key) const {
     if (has_key_local(key)) return get_entry_local(key); //< value is defined locally
-    return getPDFSet(_setname).get_entry(key); //< fall back to the set-level info... or beyond
+    return _pdfset().get_entry(key); //< fall back to the set-level info... or beyond
   }
 
 
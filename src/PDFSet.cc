@@ -4,10 +4,206 @@
 // Copyright (C) 2012-2019 The LHAPDF collaboration (see AUTHORS for details)
 //
 #include "LHAPDF/PDFSet.h"
+#include "LHAPDF/PDF.h"
+#include "LHAPDF/GridPDF.h"
+#include "LHAPDF/BinaryGrid.h"
+#include <thread>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <system_error>
+#ifdef HAVE_MPI
+#include <mpi.h>
+#include <cstdlib>
+#include <cstring>
+#endif
 
 namespace LHAPDF {
 
 
+  #ifdef HAVE_MPI
+  namespace {
+
+    /// Alignment of the images in the broadcast buffer, as for the xf blocks of a binary grid file
+    const size_t BCASTALIGN = 64;
+
+    /// Largest single broadcast message, within the int count of MPI_Bcast
+    const size_t BCASTCHUNK = size_t(1) << 30;
+
+    size_t _aligned(size_t n) {
+      return (n + BCASTALIGN - 1) / BCASTALIGN * BCASTALIGN;
+    }
+
+    /// Broadcast the @a size bytes at @a data from rank 0 of @a comm
+    void _bcastBytes(char* data, size_t size, MPI_Comm comm) {
+      for (size_t offset = 0; offset < size; offset += BCASTCHUNK)
+        MPI_Bcast(data + offset, int(min(BCASTCHUNK, size - offset)), MPI_BYTE, 0, comm);
+    }
+
+    /// Free the MPI shared-memory windows kept in an MPI_COMM_SELF attribute, when MPI_Finalize deletes it
+    int _freeWindows(MPI_Comm, int keyval, void* attr, void*) {
+      vector<MPI_Win>* wins = static_cast<vector<MPI_Win>*>(attr);
+      for (MPI_Win& win : *wins) MPI_Win_free(&win);
+      delete wins;
+      MPI_Comm_free_keyval(&keyval);
+      return MPI_SUCCESS;
+    }
+
+    /// @brief Keep the shared-memory window @a win until MPI_Finalize
+    ///
+    /// Window freeing is collective, so it can't follow the lifetime of the
+    /// PDFs. All windows go in one list, held by an attribute created on the
+    /// first call, and are freed in the same order on every rank.
+    void _keepWindow(MPI_Win win) {
+      static vector<MPI_Win>* const wins = [] {
+        int keyval;
+        MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, _freeWindows, &keyval, nullptr);
+        vector<MPI_Win>* rtn = new vector<MPI_Win>;
+        MPI_Comm_set_attr(MPI_COMM_SELF, keyval, rtn);
+        return rtn;
+      }();
+      wins->push_back(win);
+    }
+
+    /// @brief Allocate a @a size byte buffer on all ranks, and fill it by calling @a send
+    ///
+    /// @a send(data, comm) is called on every rank which takes part in the
+    /// broadcasts over @a comm, and must broadcast the contents of the buffer
+    /// from rank 0 into @a data. Without @a shared, rank 0 keeps its own copies
+    /// of the contents, so it allocates no buffer: its @a data and the return
+    /// value are null. With @a shared, the ranks on each node share the buffer
+    /// in an MPI shared-memory window, and only each node's first rank receives it.
+    template <typename FN>
+    shared_ptr<const char> _bcastBuffer(size_t size, bool shared, const FN& send) {
+      int rank(0);
+      MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+      if (!shared) {
+        if (rank == 0) {
+          send(nullptr, MPI_COMM_WORLD);
+          return nullptr;
+        }
+        void* mem = nullptr;
+        if (posix_memalign(&mem, BCASTALIGN, max(size, BCASTALIGN)) != 0) throw bad_alloc();
+        shared_ptr<char> buf(static_cast<char*>(mem), free);
+        send(buf.get(), MPI_COMM_WORLD);
+        return buf;
+      }
+
+      // Allocate the window on each node's first rank, which receives the broadcast for the node
+      MPI_Comm nodecomm, leaders;
+      MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &nodecomm);
+      int noderank(0);
+      MPI_Comm_rank(nodecomm, &noderank);
+      MPI_Comm_split(MPI_COMM_WORLD, (noderank == 0) ? 0 : MPI_UNDEFINED, rank, &leaders);
+      MPI_Win win;
+      char* base = nullptr;
+      MPI_Win_allocate_shared((noderank == 0) ? size : 0, 1, MPI_INFO_NULL, nodecomm, &base, &win);
+      if (noderank != 0) {
+        MPI_Aint qsize;
+        int qdisp;
+        MPI_Win_shared_query(win, 0, &qsize, &qdisp, &base);
+      }
+      if (leaders != MPI_COMM_NULL) {
+        send(base, leaders);
+        MPI_Comm_free(&leaders);
+      }
+      MPI_Win_fence(0, win); //< make the node leader's writes visible to the other ranks on the node
+      MPI_Comm_free(&nodecomm);
+      _keepWindow(win);
+      return shared_ptr<const char>(base, [](const char*) { });
+    }
+
+
+    /// @brief Distribute the grids of all the members of @a set from MPI rank 0, returning the member paths
+    ///
+    /// Rank 0 reads every member, parsing ASCII files into binary grid images,
+    /// without any per-file collective operations. An index of (path size,
+    /// image offset, image size) for each member and the paths are then sent
+    /// to all ranks, and the images follow in a few large broadcasts, straight
+    /// from rank 0's copies into one buffer on the other ranks. The images are
+    /// registered for GridPDF to load.
+    vector<string> _bcastMembers(const PDFSet& set) {
+      const size_t nmem = set.size();
+      int rank(0);
+      MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+      vector<string> paths(nmem);
+      vector< shared_ptr<const char> > images(nmem);
+      vector<uint64_t> index(3*nmem);
+      uint64_t header[2] = {0, 0}; //< image buffer size, or error message size if the second entry is 1
+      string error;
+      if (rank == 0) {
+        try {
+          size_t offset = 0;
+          for (size_t i = 0; i < nmem; ++i) {
+            paths[i] = findpdfmempath(set.name(), i, 1);
+            if (paths[i].empty())
+              throw ReadError("Can't find a valid PDF " + set.name() + "/" + to_str(i));
+            size_t size = 0;
+            if (isBinaryGridPath(paths[i])) {
+              images[i] = mapFile(paths[i], size);
+            } else {
+              const shared_ptr<const string> image = make_shared<const string>(GridPDF::gridImage(paths[i]));
+              images[i] = shared_ptr<const char>(image, image->data());
+              size = image->size();
+            }
+            offset = _aligned(offset);
+            index[3*i] = paths[i].size();
+            index[3*i+1] = offset;
+            index[3*i+2] = size;
+            offset += size;
+          }
+          header[0] = offset;
+        } catch (const std::exception& e) {
+          error = e.what();
+          header[0] = error.size();
+          header[1] = 1;
+        }
+      }
+      MPI_Bcast(header, 2, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+
+      // Report an error on rank 0 on all ranks
+      if (header[1] != 0) {
+        error.resize(header[0]);
+        _bcastBytes(&error[0], error.size(), MPI_COMM_WORLD);
+        throw ReadError(error);
+      }
+
+      // Send the index and the paths
+      MPI_Bcast(index.data(), int(index.size()), MPI_UINT64_T, 0, MPI_COMM_WORLD);
+      string allpaths;
+      for (size_t i = 0; i < nmem; ++i) {
+        if (rank == 0) allpaths += paths[i];
+        else allpaths.resize(allpaths.size() + index[3*i]);
+      }
+      _bcastBytes(&allpaths[0], allpaths.size(), MPI_COMM_WORLD);
+      for (size_t i = 0, pos = 0; i < nmem; pos += index[3*i], ++i)
+        paths[i].assign(allpaths, pos, index[3*i]);
+
+      // Send the images, releasing rank 0's copies once they are in a shared buffer, and register them
+      const bool shared = set.get_entry_as<bool>("MPISharedGrids", false);
+      const shared_ptr<const char> buf = _bcastBuffer(header[0], shared, [&](char* data, MPI_Comm comm) {
+        for (size_t i = 0; i < nmem; ++i) {
+          char* dest = (data != nullptr) ? data + index[3*i+1] : const_cast<char*>(images[i].get());
+          if (rank == 0 && data != nullptr) {
+            memcpy(dest, images[i].get(), index[3*i+2]);
+            images[i].reset();
+          }
+          _bcastBytes(dest, index[3*i+2], comm);
+        }
+      });
+      for (size_t i = 0; i < nmem; ++i) {
+        const shared_ptr<const char> image = buf ? shared_ptr<const char>(buf, buf.get() + index[3*i+1]) : images[i];
+        registerGridImage(paths[i], image, index[3*i+2]);
+      }
+      return paths;
+    }
+
+  }
+  #endif
+
+
   PDFSet::PDFSet(const string& setname) {
     /// @todo Hmm, this relies on the standard search path system ... currently no way to provide a absolute path
     _setname = setname;
@@ -20,6 +216,86 @@ namespace LHAPDF {
   }
 
 
+  void PDFSet::tabulate(const vector<PDF*>& pdfs, const vector<double>& xs,
+                        const vector<double>& qs, const vector<int>& ids, double* out) {
+    const size_t ntab = ids.size() * xs.size() * qs.size();
+    for (size_t imem = 0; imem < pdfs.size(); ++imem)
+      pdfs[imem]->tabulate(xs, qs, ids, out + imem*ntab);
+  }
+
+
+  void PDFSet::tabulate(const vector<PDF*>& pdfs, const vector<double>& xs,
+                        const vector<double>& qs, const vector<int>& ids, vector<double>& rtn) {
+    rtn.resize(pdfs.size() * ids.size() * xs.size() * qs.size());
+    if (!rtn.empty()) tabulate(pdfs, xs, qs, ids, &rtn[0]);
+  }
+
+
+  void PDFSet::tabulate(const vector<double>& xs, const vector<double>& qs,
+                        const vector<int>& ids, vector<double>& rtn) const {
+    vector< unique_ptr<PDF> > pdfs;
+    mkPDFs(pdfs);
+    vector<PDF*> rawpdfs;
+    for (const unique_ptr<PDF>& pdf : pdfs) rawpdfs.push_back(pdf.get());
+    tabulate(rawpdfs, xs, qs, ids, rtn);
+  }
+
+
+  void PDFSet::_mkPDFs(vector<PDF*>& pdfs) const {
+    const size_t nmem = size();
+    pdfs.assign(nmem, nullptr);
+
+    // Work out how many threads to use: 0 means one per hardware core
+    size_t nthreads = get_entry_as<unsigned int>("LoadThreads", 1);
+    if (nthreads == 0) nthreads = max(thread::hardware_concurrency(), 1u);
+    // With MPI, distribute the whole set from rank 0 up front, rather than file by file
+    vector<string> mempaths;
+    #ifdef HAVE_MPI
+    if (get_entry("Format", "lhagrid1") == "lhagrid1") mempaths = _bcastMembers(*this);
+    if (mempaths.empty()) nthreads = 1; //< file reads are MPI collective operations, so must happen in the same order on every rank
+    #endif
+    nthreads = min(nthreads, nmem);
+
+    // Each worker takes the next unloaded member until all are done, or one has failed
+    atomic<size_t> next(0);
+    exception_ptr err;
+    mutex errmutex;
+    auto worker = [&]() {
+      for (size_t i = next++; i < nmem; i = next++) {
+        try {
+          pdfs[i] = mempaths.empty() ? mkPDF(i) : new GridPDF(mempaths[i]);
+        } catch (...) {
+          lock_guard<mutex> lock(errmutex);
+          if (!err) err = current_exception();
+          next = nmem;
+        }
+      }
+    };
+    // Reserve up front so that no started thread is moved or destroyed while joinable; if a thread
+    // can't be started, carry on with those we have, since this thread's worker picks up the rest
+    vector<thread> threads;
+    threads.reserve(nthreads);
+    for (size_t i = 1; i < nthreads; ++i) {
+      try {
+        threads.emplace_back(worker);
+      } catch (const system_error&) {
+        break;
+      }
+    }
+    worker();
+    for (thread& t : threads) t.join();
+
+    // Clean up and report the first error, if there was one
+    if (err) {
+      for (PDF* pdf : pdfs) delete pdf;
+      pdfs.clear();
+      size_t size;
+      for (const string& mempath : mempaths) takeGridImage(mempath, size); //< drop any unused images
+      rethrow_exception(err);
+    }
+  }
+
+
   void PDFSet::print(ostream& os, int verbosity) const {
     stringstream ss;
     if (verbosity > 0)
@@ -0,0 +1,177 @@
+// -*- C++ -*-
+//
+// This file is part of LHAPDF
+// Copyright (C) 2012-2019 The LHAPDF collaboration (see AUTHORS for details)
+//
+#include "LHAPDF/PDFSetEvaluator.h"
+#include "LHAPDF/LogBicubicInterpolator.h"
+#include <typeinfo>
+
+namespace LHAPDF {
+
+
+  namespace {
+
+    /// Minimal unstrided [ix][iQ2] view of one member/flavor slice of a set tensor
+    struct TensorSlice {
+      const double* data;
+      size_t nq2s;
+      const double& xf(size_t ix, size_t iq2) const { return data[ix*nq2s + iq2]; }
+    };
+
+    /// Apply the PDF positivity-forcing policy, as in PDF::xfxQ2
+    inline double _forcePositive(double xfx, int level) {
+      switch (level) {
+      case 0: break;
+      case 1: if (xfx < 0) xfx = 0; break;
+      case 2: if (xfx < 1e-10) xfx = 1e-10; break;
+      default: throw LogicError("ForcePositive value not in expected range!");
+      }
+      return xfx;
+    }
+
+  }
+
+
+
+  PDFSetEvaluator::PDFSetEvaluator(const string& setname) {
+    _init(PDFSet(setname));
+  }
+
+
+  PDFSetEvaluator::PDFSetEvaluator(const PDFSet& set) {
+    _init(set);
+  }
+
+
+  PDFSetEvaluator::~PDFSetEvaluator() {
+    for (PDF* pdf : _members) delete pdf;
+  }
+
+
+  void PDFSetEvaluator::_init(const PDFSet& set) {
+    set.mkPDFs(_members);
+    if (_members.empty()) return;
+    _flavors = _members.front()->flavors();
+    sort(_flavors.begin(), _flavors.end());
+    for (const PDF* pdf : _members) _forcePos.push_back(pdf->forcePositive());
+
+    // Check that all members are log-bicubic grids with identical knots and flavors
+    vector<GridPDF*> grids;
+    for (PDF* pdf : _members) {
+      GridPDF* grid = dynamic_cast<GridPDF*>(pdf);
+      if (grid == nullptr) return;
+      // Exact type match: derived interpolators, e.g. with cached coefficients, round differently
+      if (typeid(grid->interpolator()) != typeid(LogBicubicInterpolator)) return;
+      grids.push_back(grid);
+    }
+    const map<double, KnotArrayNF>& arrays0 = grids.front()->knotarrays();
+    for (GridPDF* grid : grids) {
+      const map<double, KnotArrayNF>& arrays = grid->knotarrays();
+      if (arrays.size() != arrays0.size()) return;
+      for (map<double, KnotArrayNF>::const_iterator it = arrays.begin(), it0 = arrays0.begin(); it != arrays.end(); ++it, ++it0) {
+        if (it->first != it0->first) return;
+        if (it->second.size() != _flavors.size()) return;
+        for (int pid : _flavors) {
+          if (!it->second.has_pid(pid)) return;
+          if (it->second.get_pid(pid).geometry() != it0->second.geometry()) return;
+        }
+      }
+    }
+
+    // Repack each subgrid into a [member][flavor][ix][iQ2] tensor, and re-point the members at their slices
+    const size_t nmem = grids.size(), nfl = _flavors.size();
+    for (map<double, KnotArrayNF>::const_iterator it0 = arrays0.begin(); it0 != arrays0.end(); ++it0) {
+      SubgridTensor& t = _tensors[it0->first];
+      t.geom = it0->second.geometry();
+      const size_t nq2 = t.geom->q2s().size();
+      const size_t npts = t.geom->xs().size() * nq2;
+      t.xfs = make_shared< vector<double> >(nmem*nfl*npts);
+      for (size_t imem = 0; imem < nmem; ++imem) {
+        KnotArrayNF& arraynf = grids[imem]->knotarrays()[it0->first];
+        for (size_t ifl = 0; ifl < nfl; ++ifl) {
+          const size_t offset = (imem*nfl + ifl)*npts;
+          KnotArray1F& array1f = arraynf[_flavors[ifl]];
+          for (size_t i = 0; i < npts; ++i)
+            (*t.xfs)[offset + i] = array1f.xf(i / nq2, i % nq2);
+          array1f.setxfs(shared_ptr<const double>(t.xfs, t.xfs->data() + offset), 1);
+        }
+      }
+    }
+  }
+
+
+  bool PDFSetEvaluator::_xfxQ2Shared(double x, double q2, size_t ifl, size_t nfl, double* rtn, size_t mstride) const {
+    if (_tensors.empty()) return false;
+    const PDF& pdf0 = *_members.front();
+    if (!pdf0.inRangeXQ2(x, q2)) return false;
+
+    // Find the subgrid containing q2, as in GridPDF::subgrid
+    map<double, SubgridTensor>::const_iterator it = _tensors.upper_bound(q2);
+    if (it == _tensors.begin()) return false;
+    --it;
+    const SubgridTensor& t = it->second;
+
+    // Compute the knot indices and interpolation weights once for all members and flavors
+    const KnotGeometry& geom = *t.geom;
+    LogBicubicInterpolator::Stencil s;
+    LogBicubicInterpolator::fillStencil(s, geom, x, geom.ixbelow(x), q2, geom.iq2below(q2));
+
+    const size_t nflall = _flavors.size();
+    const size_t npts = s.nxknots * s.nq2knots;
+    TensorSlice slice;
+    slice.nq2s = s.nq2knots;
+    for (size_t imem = 0; imem < _members.size(); ++imem) {
+      for (size_t i = 0; i < nfl; ++i) {
+        slice.data = t.xfs->data() + (imem*nflall + ifl + i)*npts;
+        rtn[imem*mstride + i] = _forcePositive(LogBicubicInterpolator::interpolateStencil(slice, s), _forcePos[imem]);
+      }
+    }
+    return true;
+  }
+
+
+  void PDFSetEvaluator::xfxQ2(double x, double q2, double* rtn) const {
+    if (_members.empty()) return;
+    // Physical range checks, as in PDF::xfxQ2
+    if (!_members.front()->inPhysicalRangeX(x)) throw RangeError("Unphysical x given: " + to_str(x));
+    if (!_members.front()->inPhysicalRangeQ2(q2)) throw RangeError("Unphysical Q2 given: " + to_str(q2));
+    const size_t nfl = _flavors.size();
+    if (_xfxQ2Shared(x, q2, 0, nfl, rtn, nfl)) return;
+    // Fall back to member-by-member evaluation
+    for (size_t imem = 0; imem < _members.size(); ++imem)
+      for (size_t ifl = 0; ifl < nfl; ++ifl)
+        rtn[imem*nfl + ifl] = _members[imem]->xfxQ2(_flavors[ifl], x, q2);
+  }
+
+
+  void PDFSetEvaluator::xfxQ2(double x, double q2, vector<double>& rtn) const {
+    rtn.resize(size() * _flavors.size());
+    if (!rtn.empty()) xfxQ2(x, q2, &rtn[0]);
+  }
+
+
+  void PDFSetEvaluator::xfxQ2(int id, double x, double q2, vector<double>& rtn) const {
+    rtn.resize(size());
+    if (_members.empty()) return;
+    // Physical range checks, as in PDF::xfxQ2
+    if (!_members.front()->inPhysicalRangeX(x)) throw RangeError("Unphysical x given: " + to_str(x));
+    if (!_members.front()->inPhysicalRangeQ2(q2)) throw RangeError("Unphysical Q2 given: " + to_str(q2));
+    // Treat PID = 0 as always equivalent to a gluon
+    const int id2 = (id != 0) ? id : 21;
+    if (shared()) {
+      // All members have the same flavors: return zero for undefined PIDs
+      vector<int>::const_iterator ifl = lower_bound(_flavors.begin(), _flavors.end(), id2);
+      if (ifl == _flavors.end() || *ifl != id2) {
+        fill(rtn.begin(), rtn.end(), 0.0);
+        return;
+      }
+      if (_xfxQ2Shared(x, q2, ifl - _flavors.begin(), 1, &rtn[0], 1)) return;
+    }
+    // Fall back to member-by-member evaluation
+    for (size_t imem = 0; imem < _members.size(); ++imem)
+      rtn[imem] = _members[imem]->xfxQ2(id2, x, q2);
+  }
+
+
+}
@@ -0,0 +1,101 @@
+// -*- C++ -*-
+//
+// This file is part of LHAPDF
+// Copyright (C) 2012-2019 The LHAPDF collaboration (see AUTHORS for details)
+//
+#include "LHAPDF/ParallelEval.h"
+#include "LHAPDF/ThreadPool.h"
+#include "LHAPDF/Config.h"
+#include <algorithm>
+using namespace std;
+
+namespace LHAPDF {
+
+
+  namespace {
+
+    /// Number of queries per task of an arbitrary query list
+    const size_t QUERYCHUNK = 256;
+
+    /// Number of Q2 values per task of a query grid
+    const size_t Q2CHUNK = 256;
+
+    /// Resolve the requested number of threads, with 0 meaning the EvalThreads config entry
+    size_t _nthreads(size_t nthreads) {
+      return (nthreads != 0) ? nthreads : getConfig().get_entry_as<unsigned int>("EvalThreads", 0);
+    }
+
+    /// Freeze any PDFs which aren't already, so they can be queried concurrently
+    void _freeze(const vector<PDF*>& pdfs) {
+      for (PDF* pdf : pdfs)
+        if (!pdf->frozen()) pdf->freeze();
+    }
+
+  }
+
+
+  void xfxQ2Parallel(const vector<PDF*>& pdfs, const XQ2Query* queries, double* out, size_t n, size_t nthreads) {
+    for (size_t i = 0; i < n; ++i)
+      if (queries[i].member >= pdfs.size())
+        throw UserError("Parallel query for PDF #" + to_str(queries[i].member) + " of a list of " + to_str(pdfs.size()));
+    _freeze(pdfs);
+
+    // Each task evaluates a fixed chunk, as batches of consecutive queries of the same member and flavor
+    const size_t ntasks = (n + QUERYCHUNK - 1) / QUERYCHUNK;
+    ThreadPool::global().run(ntasks, [&](size_t itask) {
+      double xs[QUERYCHUNK], q2s[QUERYCHUNK];
+      const size_t end = min(n, (itask+1)*QUERYCHUNK);
+      for (size_t begin = itask*QUERYCHUNK; begin < end; ) {
+        const XQ2Query& q0 = queries[begin];
+        size_t nbatch = 0;
+        for (size_t i = begin; i < end && queries[i].member == q0.member && queries[i].id == q0.id; ++i) {
+          xs[nbatch] = queries[i].x;
+          q2s[nbatch] = queries[i].q2;
+          nbatch += 1;
+        }
+        pdfs[q0.member]->xfxQ2(q0.id, xs, q2s, out + begin, nbatch);
+        begin += nbatch;
+      }
+    }, _nthreads(nthreads));
+  }
+
+
+  void xfxQ2Parallel(const vector<PDF*>& pdfs, const vector<XQ2Query>& queries, vector<double>& rtn, size_t nthreads) {
+    rtn.resize(queries.size());
+    xfxQ2Parallel(pdfs, queries.data(), rtn.data(), queries.size(), nthreads);
+  }
+
+
+  void xfxQ2Parallel(const vector<PDF*>& pdfs, const vector<int>& ids,
+                     const vector<double>& xs, const vector<double>& q2s,
+                     double* out, size_t nthreads) {
+    _freeze(pdfs);
+
+    // Each task evaluates a chunk of a Q2 row, for one member and x and all flavors
+    const size_t nids = ids.size(), nxs = xs.size(), nq2s = q2s.size();
+    const size_t nq2chunks = (nq2s + Q2CHUNK - 1) / Q2CHUNK;
+    const size_t ntasks = pdfs.size() * nxs * nq2chunks;
+    ThreadPool::global().run(ntasks, [&](size_t itask) {
+      const size_t imem = itask / (nxs*nq2chunks);
+      const size_t ix = (itask / nq2chunks) % nxs;
+      const size_t iq2 = (itask % nq2chunks) * Q2CHUNK;
+      const size_t nbatch = min(Q2CHUNK, nq2s - iq2);
+      double xrow[Q2CHUNK];
+      std::fill(xrow, xrow + nbatch, xs[ix]);
+      for (size_t iid = 0; iid < nids; ++iid) {
+        double* row = out + ((imem*nids + iid)*nxs + ix)*nq2s + iq2;
+        pdfs[imem]->xfxQ2(ids[iid], xrow, q2s.data() + iq2, row, nbatch);
+      }
+    }, _nthreads(nthreads));
+  }
+
+
+  void xfxQ2Parallel(const vector<PDF*>& pdfs, const vector<int>& ids,
+                     const vector<double>& xs, const vector<double>& q2s,
+                     vector<double>& rtn, size_t nthreads) {
+    rtn.resize(pdfs.size() * ids.size() * xs.size() * q2s.size());
+    xfxQ2Parallel(pdfs, ids, xs, q2s, rtn.data(), nthreads);
+  }
+
+
+}
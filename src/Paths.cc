@@ -6,7 +6,9 @@
 #include "LHAPDF/Paths.h"
 #include "LHAPDF/Info.h"
 #include "LHAPDF/Config.h"
+#include "LHAPDF/BinaryGrid.h"
 #include <dirent.h>
+#include <sys/stat.h>
 
 #ifdef HAVE_MPI
 #include <mpi.h>
@@ -38,12 +40,12 @@ namespace LHAPDF {
   }
 
 
-  string findFile(const string& target) {
+  string findFile(const string& target, int mode) {
     if (target.empty()) return "";
     for (const string& base : paths()) {
       const string p = (startswith(target, "/") || startswith(target, ".")) ? target : base / target;
       // if (verbosity() > 2) cout << "Trying file: " << p << endl;
-      if (file_exists(p)) {
+      if (file_exists(p, mode)) {
         // if (verbosity() > 1) cout << "Found file: " << p << endl;
         return p;
       }
@@ -52,6 +54,24 @@ namespace LHAPDF {
   }
 
 
+  std::string findpdfmempath(const std::string& setname, int member, int mode) {
+    string datpath = findFile(pdfmempath(setname, member), mode);
+    for (size_t i = 0; datpath.empty() && i < compressedExtns().size(); ++i)
+      datpath = findFile(pdfmempath(setname, member) + "." + compressedExtns()[i], mode);
+    if (!Config::get().get_entry_as<bool>("BinaryGrids", true)) return datpath;
+    // Use a binary grid next to the ASCII file, unless it is older (i.e. stale)
+    if (!datpath.empty()) {
+      const string binpath = binaryGridPath(datpath);
+      struct stat datst, binst;
+      if (stat(binpath.c_str(), &binst) == 0 && stat(datpath.c_str(), &datst) == 0 && binst.st_mtime >= datst.st_mtime)
+        return binpath;
+      return datpath;
+    }
+    // Or a binary grid with no ASCII counterpart
+    return findFile(binaryGridPath(pdfmempath(setname, member)), mode);
+  }
+
+
   const std::vector<std::string>& availablePDFSets() {
     // Cached path list
     static vector<string> rtn;
@@ -59,7 +79,9 @@ namespace LHAPDF {
     if (!rtn.empty()) return rtn;
     // Otherwise this is the first time: populate the list
     #ifdef HAVE_MPI
-    if (MPI::COMM_WORLD.Get_rank()==0)
+    int rank(0);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (rank==0)
     #endif
     for (const string& p : paths()) {
       if (!dir_exists(p,1)) continue;
@@ -81,18 +103,18 @@ namespace LHAPDF {
       sort(rtn.begin(), rtn.end());
     }
     #ifdef HAVE_MPI
-    if (MPI::COMM_WORLD.Get_rank()==0) {
+    if (rank==0) {
       std::string allrtn;
       for (size_t i=0;i<rtn.size();++i) allrtn+="*"+rtn[i];
       int nchar(allrtn.length());
-      MPI::COMM_WORLD.Bcast(&nchar,1,MPI_INT,0);
-      MPI::COMM_WORLD.Bcast(&allrtn[0],nchar,MPI_CHAR,0);
+      MPI_Bcast(&nchar, 1, MPI_INT, 0, MPI_COMM_WORLD);
+      MPI_Bcast(&allrtn[0], nchar, MPI_CHAR, 0, MPI_COMM_WORLD);
     }
     else {
       int nchar;
-      MPI::COMM_WORLD.Bcast(&nchar,1,MPI_INT,0);
+      MPI_Bcast(&nchar, 1, MPI_INT, 0, MPI_COMM_WORLD);
       std::string allrtn(nchar,' ');
-      MPI::COMM_WORLD.Bcast(&allrtn[0],nchar,MPI_CHAR,0);
+      MPI_Bcast(&allrtn[0], nchar, MPI_CHAR, 0, MPI_COMM_WORLD);
       size_t bpos(allrtn.find('*'));
       while (bpos<allrtn.length()) {
       	size_t epos(std::min(allrtn.length(),allrtn.find('*',bpos+1)));
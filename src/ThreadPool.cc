@@ -0,0 +1,173 @@
+// -*- C++ -*-
+//
+// This file is part of LHAPDF
+// Copyright (C) 2012-2019 The LHAPDF collaboration (see AUTHORS for details)
+//
+#include "LHAPDF/ThreadPool.h"
+#include <algorithm>
+#include <system_error>
+using namespace std;
+
+namespace LHAPDF {
+
+
+  namespace {
+
+    /// Whether this thread is running a pool task, in which case nested runs are serial
+    thread_local bool inTask = false;
+
+  }
+
+
+  ThreadPool::ThreadPool(size_t nthreads, bool lazy)
+    : _defaultthreads((nthreads != 0) ? nthreads : max(thread::hardware_concurrency(), 1u))
+  {
+    _grow(lazy ? 1 : _defaultthreads);
+  }
+
+
+  ThreadPool::~ThreadPool() {
+    {
+      lock_guard<mutex> lock(_mutex);
+      _stopping = true;
+    }
+    _startcv.notify_all();
+    for (thread& t : _workers) t.join();
+  }
+
+
+  ThreadPool& ThreadPool::global() {
+    static ThreadPool pool(0, true);
+    return pool;
+  }
+
+
+  void ThreadPool::run(size_t ntasks, const function<void(size_t)>& task, size_t nthreads) {
+    if (nthreads == 0) nthreads = _defaultthreads;
+    nthreads = min(nthreads, ntasks);
+    if (nthreads <= 1 || inTask) {
+      for (size_t i = 0; i < ntasks; ++i) task(i);
+      return;
+    }
+
+    lock_guard<mutex> runlock(_runmutex);
+    if (nthreads > size()) _grow(nthreads);
+    nthreads = min(nthreads, size());
+    // Share the tasks out in equal contiguous ranges, before any participant starts
+    for (size_t ip = 0; ip < nthreads; ++ip) {
+      lock_guard<mutex> lock(_ranges[ip].mutex);
+      _ranges[ip].begin = ntasks*ip/nthreads;
+      _ranges[ip].end = ntasks*(ip+1)/nthreads;
+    }
+    {
+      lock_guard<mutex> lock(_mutex);
+      _task = &task;
+      _nparticipants = nthreads;
+      _nbusy = nthreads - 1;
+      _error = nullptr;
+      _failed = false;
+      _generation += 1;
+    }
+    _startcv.notify_all();
+
+    // The calling thread is participant 0
+    _work(0);
+    unique_lock<mutex> lock(_mutex);
+    _donecv.wait(lock, [this]() { return _nbusy == 0; });
+    _task = nullptr;
+    if (_error) rethrow_exception(_error);
+  }
+
+
+  void ThreadPool::_grow(size_t nthreads) {
+    // No run is active, so the task ranges can be replaced
+    unique_ptr<TaskRange[]> ranges(new TaskRange[nthreads]);
+    _ranges.swap(ranges);
+    _workers.reserve(nthreads - 1);
+    for (size_t iw = _workers.size() + 1; iw < nthreads; ++iw) {
+      try {
+        _workers.emplace_back(&ThreadPool::_workerLoop, this, iw, _generation);
+      } catch (const system_error&) {
+        break; //< carry on with the threads we have
+      }
+    }
+    _size = _workers.size() + 1;
+  }
+
+
+  void ThreadPool::_workerLoop(size_t iw, size_t generation) {
+    while (true) {
+      {
+        unique_lock<mutex> lock(_mutex);
+        _startcv.wait(lock, [&]() { return _stopping || _generation != generation; });
+        if (_stopping) return;
+        generation = _generation;
+        if (iw >= _nparticipants) continue;
+      }
+      _work(iw);
+      lock_guard<mutex> lock(_mutex);
+      if (--_nbusy == 0) _donecv.notify_one();
+    }
+  }
+
+
+  void ThreadPool::_work(size_t ip) {
+    inTask = true;
+    TaskRange& own = _ranges[ip];
+    while (!_failed) {
+      size_t i = 0;
+      bool found = false;
+      {
+        lock_guard<mutex> lock(own.mutex);
+        if (own.begin < own.end) {
+          i = own.begin++;
+          found = true;
+        }
+      }
+      if (!found) {
+        if (!_steal(ip)) break;
+        continue;
+      }
+      try {
+        (*_task)(i);
+      } catch (...) {
+        lock_guard<mutex> lock(_mutex);
+        if (!_error) _error = current_exception();
+        _failed = true;
+      }
+    }
+    inTask = false;
+  }
+
+
+  bool ThreadPool::_steal(size_t ip) {
+    while (true) {
+      // Find the participant with the most tasks left
+      size_t victim = ip, nmax = 0;
+      for (size_t k = 1; k < _nparticipants; ++k) {
+        const size_t iv = (ip + k) % _nparticipants;
+        lock_guard<mutex> lock(_ranges[iv].mutex);
+        const size_t n = _ranges[iv].end - _ranges[iv].begin;
+        if (n > nmax) { nmax = n; victim = iv; }
+      }
+      if (nmax == 0) return false;
+
+      // Take the upper half of its range, or retry if it has meanwhile run out
+      size_t begin, end;
+      {
+        lock_guard<mutex> lock(_ranges[victim].mutex);
+        TaskRange& r = _ranges[victim];
+        if (r.begin == r.end) continue;
+        end = r.end;
+        begin = r.begin + (r.end - r.begin)/2;
+        r.end = begin;
+      }
+      lock_guard<mutex> lock(_ranges[ip].mutex);
+      _ranges[ip].begin = begin;
+      _ranges[ip].end = end;
+      return true;
+    }
+  }
+
+
+}
@@ -24,11 +24,13 @@ namespace LHAPDF {
   {
     int exists(false);
     #ifdef HAVE_MPI
-    if (mode==1 || MPI::COMM_WORLD.Get_rank()==0) {
+    int rank(0);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (mode==1 || rank==0) {
       struct stat fst;
       if (stat(file.c_str(), &fst) != -1) exists = (fst.st_mode & S_IFMT) == S_IFREG;
     }
-    if (mode!=1) MPI::COMM_WORLD.Bcast(&exists,1,MPI_INT,0);
+    if (mode!=1) MPI_Bcast(&exists, 1, MPI_INT, 0, MPI_COMM_WORLD);
     #else
     struct stat fst;
     if (stat(file.c_str(), &fst) != -1) exists = (fst.st_mode & S_IFMT) == S_IFREG;
@@ -41,11 +43,13 @@ namespace LHAPDF {
   {
     int exists(false);
     #ifdef HAVE_MPI
-    if (mode==1 || MPI::COMM_WORLD.Get_rank()==0) {
+    int rank(0);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (mode==1 || rank==0) {
       struct stat fst;
       if (stat(dir.c_str(), &fst) != -1) exists = (fst.st_mode & S_IFMT) == S_IFDIR;
     }
-    if (mode!=1) MPI::COMM_WORLD.Bcast(&exists,1,MPI_INT,0);
+    if (mode!=1) MPI_Bcast(&exists, 1, MPI_INT, 0, MPI_COMM_WORLD);
     #else
     struct stat fst;
     if (stat(dir.c_str(), &fst) != -1) exists = (fst.st_mode & S_IFMT) == S_IFDIR;
@@ -0,0 +1,30 @@
+// -*- C++ -*-
+//
+// This file is part of LHAPDF
+// Copyright (C) 2012-2019 The LHAPDF collaboration (see AUTHORS for details)
+//
+#pragma once
+#ifndef LHAPDF_TestCompare_H
+#define LHAPDF_TestCompare_H
+
+// Comparison of computed values, shared by the test programs
+
+#include <cmath>
+#include <algorithm>
+
+namespace LHAPDF {
+
+
+  /// @brief Whether @a a and @a b agree to the tolerance @a tol, with 0 meaning exactly
+  ///
+  /// The tolerance is relative to the larger of their magnitudes, or to
+  /// @a scale if that is larger, for values which may cancel to near zero.
+  /// NaNs, e.g. from the extrapolation of zero-valued grids, agree with each other.
+  inline bool agree(double a, double b, double tol=0, double scale=0) {
+    if (std::isnan(a) || std::isnan(b)) return std::isnan(a) && std::isnan(b);
+    return a == b || std::abs(a - b) <= tol*std::max(scale, std::max(std::abs(a), std::abs(b)));
+  }
+
+
+}
+#endif
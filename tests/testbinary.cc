@@ -0,0 +1,193 @@
+// Program to test binary grid images: round trips, rejection of truncated or corrupt images,
+// and loading via the shared-memory grid store and the on-disk grid cache
+
+#include "LHAPDF/LHAPDF.h"
+#include "LHAPDF/GridPDF.h"
+#include "LHAPDF/BinaryGrid.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <unistd.h>
+#include <fcntl.h>
+#include <utime.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+using namespace std;
+
+// Count the knot values of @a arrays which differ from those of @a pdf
+size_t compareGrids(const LHAPDF::GridPDF& pdf, const map<double, LHAPDF::KnotArrayNF>& arrays) {
+  size_t nbad = (arrays.size() == pdf.knotarrays().size()) ? 0 : 1;
+  for (const auto& q2_ka : pdf.knotarrays()) {
+    if (arrays.count(q2_ka.first) == 0) { nbad += 1; continue; }
+    const LHAPDF::KnotArrayNF& ka = arrays.find(q2_ka.first)->second;
+    for (int pid : pdf.flavors()) {
+      const LHAPDF::KnotArray1F& ref = q2_ka.second.get_pid(pid);
+      const LHAPDF::KnotArray1F& grid = ka.get_pid(pid);
+      if (grid.xs() != ref.xs() || grid.q2s() != ref.q2s()) { nbad += 1; continue; }
+      for (size_t ix = 0; ix < ref.xsize(); ++ix)
+        for (size_t iq2 = 0; iq2 < ref.q2size(); ++iq2)
+          if (grid.xf(ix, iq2) != ref.xf(ix, iq2)) nbad += 1;
+    }
+  }
+  return nbad;
+}
+
+// Read the image @a img, returning false if it is rejected with a ReadError
+bool readImage(const string& img) {
+  shared_ptr<char> data(new char[img.size()], default_delete<char[]>());
+  memcpy(data.get(), img.data(), img.size());
+  map<double, LHAPDF::KnotArrayNF> arrays;
+  string metadata;
+  try {
+    LHAPDF::readGridImage(data, img.size(), "test image", arrays, &metadata);
+  } catch (const LHAPDF::ReadError&) {
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+
+  const string setname = (argc > 1) ? argv[1] : "CT10nlo";
+  LHAPDF::setVerbosity(0);
+  const LHAPDF::GridPDF pdf(setname, 0);
+
+  // Round trip through an in-memory image
+  size_t nbad = 0;
+  const string img = LHAPDF::binaryGridImage(pdf.knotarrays(), pdf.flavors(), "Test: metadata\n");
+  shared_ptr<char> data(new char[img.size()], default_delete<char[]>());
+  memcpy(data.get(), img.data(), img.size());
+  map<double, LHAPDF::KnotArrayNF> arrays;
+  string metadata;
+  LHAPDF::readGridImage(data, img.size(), "test image", arrays, &metadata);
+  nbad += compareGrids(pdf, arrays) + (metadata == "Test: metadata\n" ? 0 : 1);
+  cout << "Round trip of a " << img.size() << " byte image: " << nbad << " differences" << endl;
+
+  // Truncation at every 8-byte boundary must be detected
+  size_t naccepted = 0;
+  for (size_t size = 0; size < img.size(); size += 8)
+    if (readImage(img.substr(0, size))) naccepted += 1;
+
+  // Huge counts in the first subgrid header, including ones whose products or
+  // sums wrap around, must be rejected before any out-of-range access
+  const size_t metalen = *reinterpret_cast<const uint64_t*>(img.data() + 24);
+  const size_t suboffset = 64 + (metalen + 7) / 8 * 8;
+  const uint64_t hugevals[] = {uint64_t(1) << 61, uint64_t(1) << 62, ~uint64_t(0), ~uint64_t(0) / 8 + 1, uint64_t(1) << 32};
+  for (size_t ifield = 0; ifield < 3; ++ifield) {
+    for (uint64_t v : hugevals) {
+      string bad = img;
+      memcpy(&bad[suboffset + 8*ifield], &v, 8);
+      if (readImage(bad)) naccepted += 1;
+    }
+  }
+  // ... and likewise a huge metadata length
+  for (uint64_t v : hugevals) {
+    string bad = img;
+    memcpy(&bad[24], &v, 8);
+    if (readImage(bad)) naccepted += 1;
+  }
+  cout << "Corrupt images accepted: " << naccepted << endl;
+  nbad += naccepted;
+
+  // Load through the shared-memory store and the grid cache: the first load of each publishes
+  // the parsed member, and the second reuses it. The first is lazy, so the image is made on
+  // first use, and must leave metadata set since the PDF's construction untouched.
+  const string mempath = LHAPDF::findpdfmempath(setname, 0);
+  char cachedir[] = "/tmp/lhapdf-testbinary-XXXXXX";
+  if (mkdtemp(cachedir) == nullptr) {
+    cerr << "Could not create a temporary grid cache directory" << endl;
+    return 1;
+  }
+  LHAPDF::removeSharedGrid(mempath);
+  size_t nbadstores = 0;
+  for (const string store : {"SharedMemoryGrids", "GridCacheDir"}) {
+    if (store == "SharedMemoryGrids") LHAPDF::getConfig().set_entry("SharedMemoryGrids", true);
+    else LHAPDF::getConfig().set_entry("GridCacheDir", string(cachedir));
+    for (int pass = 0; pass < 2; ++pass) {
+      LHAPDF::getConfig().set_entry("LazyLoad", pass == 0);
+      LHAPDF::GridPDF spdf(setname, 0);
+      spdf.info().set_entry("TestBinaryEntry", "kept");
+      nbadstores += compareGrids(pdf, spdf.knotarrays());
+      if (spdf.info().get_entry("TestBinaryEntry", "") != "kept") nbadstores += 1;
+    }
+    LHAPDF::getConfig().set_entry("LazyLoad", false);
+    if (store == "SharedMemoryGrids") {
+      LHAPDF::getConfig().set_entry("SharedMemoryGrids", false);
+      if (!LHAPDF::removeSharedGrid(mempath)) nbadstores += 1; //< it must have been published
+    } else {
+      const string cachepath = LHAPDF::gridCachePath(mempath);
+      if (remove(cachepath.c_str()) != 0) nbadstores += 1; //< it must have been written
+      LHAPDF::getConfig().set_entry("GridCacheDir", string(""));
+    }
+  }
+
+  // Publishing the image of an updated member file removes the segment of its previous version. The
+  // file is a copy in a directory named after the set, so that its metadata is still found, and the
+  // lock file goes in the same temporary directory
+  const string setdir = string(cachedir) + "/" + setname;
+  const string copypath = setdir + "/" + LHAPDF::basename(mempath);
+  mkdir(setdir.c_str(), 0755);
+  {
+    ifstream src(mempath.c_str(), ios::binary);
+    ofstream dst(copypath.c_str(), ios::binary);
+    dst << src.rdbuf();
+  }
+  const char* tmpdir = getenv("TMPDIR");
+  const string oldtmpdir = (tmpdir != nullptr) ? tmpdir : "";
+  setenv("TMPDIR", cachedir, 1);
+  LHAPDF::getConfig().set_entry("SharedMemoryGrids", true);
+  vector<string> names;
+  for (time_t mtime : {1000000000, 1000000001}) {
+    const struct utimbuf times = {mtime, mtime};
+    utime(copypath.c_str(), &times);
+    names.push_back(LHAPDF::sharedGridName(copypath));
+    LHAPDF::GridPDF cpdf(copypath);
+    nbadstores += compareGrids(pdf, cpdf.knotarrays());
+  }
+  LHAPDF::getConfig().set_entry("SharedMemoryGrids", false);
+  const int oldfd = shm_open(names[0].c_str(), O_RDONLY, 0);
+  if (oldfd >= 0) {
+    cerr << "Superseded shared-memory segment " << names[0] << " was not removed" << endl;
+    close(oldfd);
+    shm_unlink(names[0].c_str());
+    nbadstores += 1;
+  }
+  if (!LHAPDF::removeSharedGrid(copypath)) nbadstores += 1;
+
+  // A grid cache entry is kept rather than rebuilt if only the source's mtime changes, and passes the
+  // checksum verification of every load when that is requested
+  LHAPDF::getConfig().set_entry("GridCacheDir", string(cachedir));
+  ino_t inode = 0;
+  for (const pair<time_t, bool>& mtime_verify : vector< pair<time_t, bool> >{{1000000002, false}, {1000000003, false}, {1000000003, true}}) {
+    const struct utimbuf times = {mtime_verify.first, mtime_verify.first};
+    utime(copypath.c_str(), &times);
+    LHAPDF::getConfig().set_entry("GridCacheVerify", mtime_verify.second);
+    LHAPDF::GridPDF cpdf(copypath);
+    nbadstores += compareGrids(pdf, cpdf.knotarrays());
+    struct stat st;
+    if (stat(LHAPDF::gridCachePath(copypath).c_str(), &st) != 0 || (inode != 0 && st.st_ino != inode)) {
+      cerr << "Grid cache entry for " << copypath << " was rebuilt or not written" << endl;
+      nbadstores += 1;
+    }
+    inode = st.st_ino;
+  }
+  LHAPDF::getConfig().set_entry("GridCacheVerify", false);
+  LHAPDF::getConfig().set_entry("GridCacheDir", string(""));
+
+  if (oldtmpdir.empty()) unsetenv("TMPDIR"); else setenv("TMPDIR", oldtmpdir.c_str(), 1);
+  remove(copypath.c_str());
+  rmdir(setdir.c_str());
+  DIR* dir = opendir(cachedir); //< the lock file and grid cache entry
+  for (struct dirent* entry = readdir(dir); entry != nullptr; entry = readdir(dir))
+    if (entry->d_name[0] != '.') remove((string(cachedir) + "/" + entry->d_name).c_str());
+  closedir(dir);
+
+  rmdir(cachedir);
+  cout << "Shared-memory store and grid cache loads: " << nbadstores << " differences" << endl;
+  nbad += nbadstores;
+
+  return (nbad == 0) ? 0 : 1;
+}
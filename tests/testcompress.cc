@@ -0,0 +1,101 @@
+// Program to test reading compressed member data files, against the plain file
+
+#include "LHAPDF/LHAPDF.h"
+#include "LHAPDF/GridPDF.h"
+#include "LHAPDF/FileIO.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+using namespace std;
+
+// Write @a content to @a path, compressed with the codec for its extension
+bool writeCompressed(const string& content, const string& path) {
+  #ifdef HAVE_ZLIB
+  if (LHAPDF::file_extn(path) == "gz") {
+    gzFile f = gzopen(path.c_str(), "wb");
+    if (f == nullptr) return false;
+    const bool ok = gzwrite(f, content.data(), content.size()) == int(content.size());
+    return (gzclose(f) == Z_OK) && ok;
+  }
+  #endif
+  #ifdef HAVE_ZSTD
+  if (LHAPDF::file_extn(path) == "zst") {
+    // Written as two frames, which must be read back as one stream
+    ofstream f(path.c_str(), ios::binary);
+    const size_t half = content.size() / 2;
+    for (const string& part : {content.substr(0, half), content.substr(half)}) {
+      string buf(ZSTD_compressBound(part.size()), '\0');
+      const size_t n = ZSTD_compress(&buf[0], buf.size(), part.data(), part.size(), 3);
+      if (ZSTD_isError(n)) return false;
+      f.write(buf.data(), n);
+    }
+    return bool(f);
+  }
+  #endif
+  return false;
+}
+
+int main(int argc, char* argv[]) {
+
+  const string setname = (argc > 1) ? argv[1] : "CT10nlo";
+  LHAPDF::setVerbosity(0);
+  const LHAPDF::GridPDF ref(setname, 0);
+  if (LHAPDF::compressedExtns().empty()) {
+    cout << "No compression codecs in this build" << endl;
+    return 0;
+  }
+
+  // Read the plain member file, to make compressed copies of it
+  const string mempath = LHAPDF::findpdfmempath(setname, 0);
+  ifstream plain(mempath.c_str(), ios::binary);
+  stringstream content;
+  content << plain.rdbuf();
+
+  // The copies go in a directory named after the set, so that its metadata is still found
+  char tmpdir[] = "/tmp/lhapdf-testcompress-XXXXXX";
+  if (mkdtemp(tmpdir) == nullptr) {
+    cerr << "Could not create a temporary directory" << endl;
+    return 1;
+  }
+  const string setdir = string(tmpdir) + "/" + setname;
+  mkdir(setdir.c_str(), 0755);
+
+  size_t nbad = 0;
+  for (const string& extn : LHAPDF::compressedExtns()) {
+    const string path = setdir + "/" + LHAPDF::basename(mempath) + "." + extn;
+    if (!writeCompressed(content.str(), path)) {
+      cerr << "Could not write " << path << endl;
+      nbad += 1;
+      continue;
+    }
+    // Read eagerly, and lazily, which reads through the header again
+    size_t nbadextn = 0;
+    for (bool lazy : {false, true}) {
+      LHAPDF::getConfig().set_entry("LazyLoad", lazy);
+      const LHAPDF::GridPDF pdf(path);
+      for (double log10x = -7.0; log10x < 0.0; log10x += 0.1)
+        for (double log10q = 0.0; log10q <= 4.0; log10q += 0.1)
+          for (int pid : ref.flavors())
+            if (pdf.xfxQ(pid, pow(10, log10x), pow(10, log10q)) != ref.xfxQ(pid, pow(10, log10x), pow(10, log10q))) nbadextn += 1;
+    }
+    LHAPDF::getConfig().set_entry("LazyLoad", false);
+    cout << "." << extn << " member: " << nbadextn << " differences from the plain file" << endl;
+    nbad += nbadextn;
+    remove(path.c_str());
+  }
+  rmdir(setdir.c_str());
+  rmdir(tmpdir);
+
+  return (nbad == 0) ? 0 : 1;
+}
@@ -0,0 +1,56 @@
+// Program to test the collective loading of a PDF set in an MPI job, e.g. by
+//   mpirun -np 4 tests/testmpi CT10nlo
+
+#include "LHAPDF/LHAPDF.h"
+#include <mpi.h>
+#include <iostream>
+#include <cmath>
+#include <ctime>
+using namespace std;
+
+// Count the differences between the broadcast-loaded PDFs and the same members loaded file by file
+size_t compareMembers(const vector<LHAPDF::PDF*>& pdfs, const string& setname) {
+  size_t nbad = 0;
+  for (size_t imem = 0; imem < pdfs.size(); ++imem) {
+    const LHAPDF::PDF* ref = LHAPDF::mkPDF(setname, imem);
+    for (double log10x = -7.5; log10x <= 0.0; log10x += 0.5) {
+      for (double log10q = 0.5; log10q <= 4.0; log10q += 0.5) {
+        for (int pid : ref->flavors()) {
+          const double x = pow(10, log10x), q = pow(10, log10q);
+          if (pdfs[imem]->xfxQ(pid, x, q) != ref->xfxQ(pid, x, q)) nbad += 1;
+        }
+      }
+    }
+    delete ref;
+  }
+  return nbad;
+}
+
+int main(int argc, char* argv[]) {
+  MPI_Init(&argc, &argv);
+  int rank(0);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  const string setname = (argc > 1) ? argv[1] : "CT10nlo";
+  LHAPDF::setVerbosity(0);
+
+  size_t nbad = 0;
+  // Each way twice, so that shared-memory windows from more than one load are kept until MPI_Finalize
+  for (const bool shared : {false, true, false, true}) {
+    LHAPDF::getConfig().set_entry("MPISharedGrids", shared);
+    const clock_t start = clock();
+    const vector<LHAPDF::PDF*> pdfs = LHAPDF::mkPDFs(setname);
+    const clock_t end = clock();
+    const size_t nbadset = compareMembers(pdfs, setname);
+    if (rank == 0)
+      cout << (shared ? "Node-shared" : "Per-rank") << " set loading: " << pdfs.size() << " members in "
+           << double(end - start)/CLOCKS_PER_SEC << " s, " << nbadset << " differences on rank 0" << endl;
+    nbad += nbadset;
+    for (const LHAPDF::PDF* pdf : pdfs) delete pdf;
+  }
+
+  unsigned long nbadlocal = nbad, nbadall = 0;
+  MPI_Allreduce(&nbadlocal, &nbadall, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+  if (rank == 0) cout << nbadall << " differences on all ranks" << endl;
+  MPI_Finalize();
+  return (nbadall == 0) ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+// Program to test the grid data number scanner against std::strtod, on both its parsing paths
+
+#include "../src/NumScanner.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+using namespace std;
+
+// Count the tokens of @a line which the scanner reads differently from strtod: a different
+// value (bit for bit, or not both NaN), or a different end position
+template <bool FROMCHARS>
+size_t compareLine(const string& line) {
+  LHAPDF::NumScanner<FROMCHARS> scanner(line.c_str(), line.c_str() + line.size());
+  const char* p = line.c_str();
+  size_t nbad = 0;
+  while (true) {
+    char* endptr;
+    const double ref = strtod(p, &endptr);
+    double x;
+    const bool ok = scanner.next(x);
+    if (endptr == p) return nbad + (ok ? 1 : 0); //< both must stop at the end or a malformed token
+    if (!ok || scanner.unread() != endptr) return nbad + 1;
+    if (memcmp(&x, &ref, sizeof(double)) != 0 && !(std::isnan(x) && std::isnan(ref))) nbad += 1;
+    p = endptr;
+  }
+}
+
+int main() {
+
+  // Awkward cases: signs, zeros, leading and trailing digits, huge and tiny exponents,
+  // subnormals, overflow, halfway cases, long mantissas, hex and non-numbers
+  vector<string> lines = {
+    "0 -0 +0 0.0 -0.0 .5 -.5 +.5 5. 1e0 1E+0 1e-0 +1.5e+3 -1.5E-3",
+    "1e22 1e23 9007199254740992 9007199254740993 9007199254740991e22 123456789012345678901",
+    "1e-22 1e-23 4.9406564584124654e-324 2.2250738585072011e-308 2.2250738585072014e-308",
+    "1.7976931348623157e308 1.7976931348623159e308 1e400 -1e400 1e-400 0.1 0.2 0.3",
+    "2.5 3.5 0.30000000000000004 1.00000000000000011102230246251565404 7.038531e-26",
+    "0x10 0X1p3 -0x1.8p1 inf -Infinity nan",
+    "1e", "1e+ 2", "1.2.3", "--1", "+-1", "- 1", "+ 1", ". 1",
+    "\t 1.0\t\t2.0  \r",
+    "00000000000000000000012 0.000000000000000000000000001 1234567890123456789e-40",
+  };
+
+  // Typical grid data lines, as written by various generators, at several precisions
+  mt19937_64 rng(12345);
+  uniform_real_distribution<double> mantissa(-10.0, 10.0);
+  uniform_int_distribution<int> exponent(-40, 40), ndigits(1, 17);
+  char buf[64];
+  for (size_t iline = 0; iline < 20000; ++iline) {
+    string line;
+    for (size_t i = 0; i < 11; ++i) {
+      const double v = mantissa(rng) * pow(10.0, exponent(rng));
+      const int n = ndigits(rng);
+      switch (i % 3) {
+      case 0: snprintf(buf, sizeof(buf), "%.*e", n, v); break;
+      case 1: snprintf(buf, sizeof(buf), "%.*g", n, v); break;
+      default: snprintf(buf, sizeof(buf), "%.*f", n % 10, v); break;
+      }
+      line += string(i > 0 ? " " : "") + buf;
+    }
+    lines.push_back(line);
+  }
+  // Random bit patterns, printed exactly
+  for (size_t iline = 0; iline < 2000; ++iline) {
+    string line;
+    for (size_t i = 0; i < 8; ++i) {
+      const uint64_t bits = rng();
+      double v;
+      memcpy(&v, &bits, sizeof(double));
+      snprintf(buf, sizeof(buf), "%.17g", v);
+      line += string(i > 0 ? " " : "") + buf;
+    }
+    lines.push_back(line);
+  }
+
+  size_t nbadfast = 0, nbadfromchars = 0;
+  for (const string& line : lines) {
+    nbadfast += compareLine<false>(line);
+    #if LHAPDF_FROM_CHARS
+    nbadfromchars += compareLine<true>(line);
+    #endif
+  }
+  cout << "Fast-path scanner: " << nbadfast << " differences from strtod in " << lines.size() << " lines" << endl;
+  #if LHAPDF_FROM_CHARS
+  cout << "from_chars scanner: " << nbadfromchars << " differences from strtod" << endl;
+  #else
+  cout << "from_chars scanner: not available in this build" << endl;
+  #endif
+
+  return (nbadfast + nbadfromchars == 0) ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+// Program to measure the scaling of parallel batch PDF evaluation with the number of threads
+
+#include "LHAPDF/LHAPDF.h"
+#include "LHAPDF/ThreadPool.h"
+#include <iostream>
+#include <cmath>
+#include <chrono>
+using namespace std;
+
+int main(int argc, char* argv[]) {
+
+  const string setname = (argc > 1) ? argv[1] : "CT10nlo";
+  // By default up to one thread per core, the library pool's default
+  const size_t maxthreads = (argc > 2) ? stoi(argv[2]) : LHAPDF::ThreadPool::global().defaultThreads();
+  const size_t nxs = (argc > 3) ? stoi(argv[3]) : 100;
+  const size_t nq2s = (argc > 4) ? stoi(argv[4]) : 100;
+  LHAPDF::setVerbosity(0);
+
+  const vector<LHAPDF::PDF*> pdfs = LHAPDF::mkPDFs(setname);
+  const vector<int>& ids = pdfs.front()->flavors();
+  vector<double> xs, q2s;
+  for (size_t i = 0; i < nxs; ++i) xs.push_back(pow(10, -7.0 + 7.0*i/nxs));
+  for (size_t i = 0; i < nq2s; ++i) q2s.push_back(pow(10, 0.5 + 8.0*i/nq2s));
+
+  // The same evaluations as an arbitrary query list
+  vector<LHAPDF::XQ2Query> queries;
+  for (size_t imem = 0; imem < pdfs.size(); ++imem)
+    for (int id : ids)
+      for (double x : xs)
+        for (double q2 : q2s)
+          queries.push_back({imem, id, x, q2});
+  cout << queries.size() << " evaluations of " << setname << ", on up to " << maxthreads << " threads" << endl;
+
+  vector<double> refgrid, refquery, xfs;
+  double t1grid = 0, t1query = 0;
+  size_t nbad = 0;
+  for (size_t nthreads = 1; nthreads <= maxthreads; nthreads *= 2) {
+    const auto start = chrono::steady_clock::now();
+    LHAPDF::xfxQ2Parallel(pdfs, ids, xs, q2s, xfs, nthreads);
+    const auto mid = chrono::steady_clock::now();
+    if (nthreads == 1) refgrid = xfs;
+    else if (xfs != refgrid) nbad += 1;
+    LHAPDF::xfxQ2Parallel(pdfs, queries, xfs, nthreads);
+    const auto end = chrono::steady_clock::now();
+    if (nthreads == 1) refquery = xfs;
+    else if (xfs != refquery) nbad += 1;
+
+    const double tgrid = chrono::duration<double>(mid - start).count();
+    const double tquery = chrono::duration<double>(end - mid).count();
+    if (nthreads == 1) { t1grid = tgrid; t1query = tquery; }
+    cout << nthreads << " threads: grid " << tgrid << " s (x" << t1grid/tgrid << "), "
+         << "query list " << tquery << " s (x" << t1query/tquery << ")" << endl;
+  }
+  // The grid and query-list evaluations are the same batches of the same points
+  if (refgrid != refquery) nbad += 1;
+  if (nbad > 0) cout << nbad << " results differ from the single-threaded ones" << endl;
+
+  for (LHAPDF::PDF* pdf : pdfs) delete pdf;
+  return (nbad == 0) ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+// Program to test reduced-precision xf storage against the double-precision grids
+
+#include "LHAPDF/LHAPDF.h"
+#include "LHAPDF/GridPDF.h"
+#include <iostream>
+#include <cmath>
+using namespace std;
+
+// Load member 0 of the set with the given xf storage precision
+LHAPDF::GridPDF* mkGridPDF(const string& setname, const string& prec) {
+  LHAPDF::getConfig().set_entry("XfPrecision", prec);
+  LHAPDF::GridPDF* pdf = dynamic_cast<LHAPDF::GridPDF*>(LHAPDF::mkPDF(setname, 0));
+  if (pdf == nullptr) throw LHAPDF::UserError("PDF set " + setname + " is not grid-based");
+  return pdf;
+}
+
+int main(int argc, char* argv[]) {
+
+  const string setname = (argc > 1) ? argv[1] : "CT10nlo";
+  LHAPDF::GridPDF* pdfd = mkGridPDF(setname, "double");
+
+  // The documented maximum relative errors, and the LOG16 flush-to-zero threshold
+  const double relerr_float = pow(2.0, -24);
+  const double relerr_log16 = pow(2.0, LHAPDF::KnotArray1F::LOG16RANGE/65532) - 1;
+  const double flush_log16 = pow(2.0, -LHAPDF::KnotArray1F::LOG16RANGE);
+
+  size_t nbad = 0;
+  for (const string prec : {"float", "log16"}) {
+    LHAPDF::GridPDF* pdfp = mkGridPDF(setname, prec);
+    const bool log16 = (prec == "log16");
+    const double relerr = log16 ? relerr_log16 : relerr_float;
+
+    // Compare each stored knot value with its double-precision original
+    double maxrel = 0;
+    for (const auto& q2_ka : pdfd->knotarrays()) {
+      const LHAPDF::KnotArrayNF& kad = q2_ka.second;
+      const LHAPDF::KnotArrayNF& kap = pdfp->knotarrays().find(q2_ka.first)->second;
+      for (int pid : pdfd->flavors()) {
+        const LHAPDF::KnotArray1F& gd = kad.get_pid(pid);
+        const LHAPDF::KnotArray1F& gp = kap.get_pid(pid);
+        // The LOG16 blocks are consecutive values in the [ix][iQ2] order
+        vector<double> blockmax((gd.size() + LHAPDF::KnotArray1F::LOG16BLOCK - 1) / LHAPDF::KnotArray1F::LOG16BLOCK, 0.0);
+        for (size_t i = 0; i < gd.size(); ++i) {
+          double& m = blockmax[i / LHAPDF::KnotArray1F::LOG16BLOCK];
+          m = max(m, abs(gd.xf(i / gd.q2size(), i % gd.q2size())));
+        }
+        for (size_t i = 0; i < gd.size(); ++i) {
+          const double vd = gd.xf(i / gd.q2size(), i % gd.q2size());
+          const double vp = gp.xf(i / gp.q2size(), i % gp.q2size());
+          const double tol = relerr*abs(vd)*(1 + 1e-9) +
+            (log16 ? flush_log16*blockmax[i / LHAPDF::KnotArray1F::LOG16BLOCK] : 0);
+          if (abs(vp - vd) > tol) nbad += 1;
+          if (vd != 0) maxrel = max(maxrel, abs(vp - vd)/abs(vd));
+        }
+      }
+    }
+    cout << prec << ": max relative knot error = " << maxrel << " (bound " << relerr << ")" << endl;
+
+    // Interpolation is linear in the knot values, so interpolated values follow the same bounds
+    double maxdiff = 0;
+    for (double log10x = -7.0; log10x < 0.0; log10x += 0.1) {
+      for (double log10q = 0.5; log10q <= 3.0; log10q += 0.1) {
+        const double x = pow(10, log10x), q2 = pow(10, 2*log10q);
+        const double ref = pdfd->xfxQ2(21, x, q2);
+        maxdiff = max(maxdiff, abs(pdfp->xfxQ2(21, x, q2) - ref)/abs(ref));
+      }
+    }
+    cout << prec << ": max relative gluon interpolation difference = " << maxdiff << endl;
+    if (maxdiff > 10*relerr) nbad += 1;
+    delete pdfp;
+  }
+
+  // Reduced precision can't be combined with the (double-precision) interleaved layout
+  LHAPDF::getConfig().set_entry("InterleaveFlavors", true);
+  try {
+    delete mkGridPDF(setname, "float");
+    cerr << "XfPrecision was accepted with InterleaveFlavors" << endl;
+    nbad += 1;
+  } catch (const LHAPDF::MetadataError&) { }
+  LHAPDF::getConfig().set_entry("InterleaveFlavors", false);
+
+  delete pdfd;
+  if (nbad > 0) {
+    cerr << nbad << " reduced-precision storage errors outside the documented bounds" << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,58 @@
+// Program to test and time the tabulation of whole PDF sets on fixed x and Q nodes, against single-point queries
+
+#include "LHAPDF/LHAPDF.h"
+#include "LHAPDF/GridPDF.h"
+#include "TestCompare.h"
+#include <iostream>
+#include <cmath>
+#include <chrono>
+using namespace std;
+
+// Count the differences between the [member][flavor][x][Q] table @a tab and single-point xfxQ calls
+size_t compare(const vector<LHAPDF::PDF*>& pdfs, const vector<double>& xs, const vector<double>& qs,
+               const vector<int>& ids, const vector<double>& tab, double& tpoints) {
+  size_t nbad = 0, i = 0;
+  const auto start = chrono::steady_clock::now();
+  for (const LHAPDF::PDF* pdf : pdfs)
+    for (int id : ids)
+      for (double x : xs)
+        for (double q : qs)
+          if (!LHAPDF::agree(tab[i++], pdf->xfxQ(id, x, q), 1e-10, 1.0)) nbad += 1;
+  tpoints = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  return nbad;
+}
+
+int main(int argc, char* argv[]) {
+
+  const string setname = (argc > 1) ? argv[1] : "CT10nlo";
+  const size_t nxs = (argc > 2) ? stoi(argv[2]) : 30;
+  const size_t nqs = (argc > 3) ? stoi(argv[3]) : 100;
+  LHAPDF::setVerbosity(0);
+
+  // Nodes spanning the grids, with a few in the extrapolation regions
+  vector<double> xs, qs;
+  for (size_t i = 0; i < nxs; ++i) xs.push_back(pow(10, -8.0 + 8.0*i/(nxs-1)));
+  for (size_t i = 0; i < nqs; ++i) qs.push_back(pow(10, 0.0 + 4.5*i/(nqs-1)));
+  const vector<int> ids = {-6, -5, -4, -3, -2, -1, 21, 1, 2, 3, 4, 5, 6};
+
+  const vector<LHAPDF::PDF*> pdfs = LHAPDF::mkPDFs(setname);
+  vector<double> tab;
+  const auto start = chrono::steady_clock::now();
+  LHAPDF::PDFSet::tabulate(pdfs, xs, qs, ids, tab);
+  const double ttab = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  double tpoints;
+  size_t nbad = compare(pdfs, xs, qs, ids, tab, tpoints);
+  cout << pdfs.size() << "x" << ids.size() << "x" << nxs << "x" << nqs << " table of " << setname << ": "
+       << 1000*ttab << " ms, vs. " << 1000*tpoints << " ms point by point, " << nbad << " differences" << endl;
+
+  // A non-separable interpolator, tabulated by the fall-back
+  LHAPDF::GridPDF pdf(setname, 0);
+  pdf.setInterpolator(string("log"));
+  pdf.tabulate(xs, qs, ids, tab);
+  const size_t nbadlin = compare({&pdf}, xs, qs, ids, tab, tpoints);
+  cout << "Log-bilinear table: " << nbadlin << " differences" << endl;
+  nbad += nbadlin;
+
+  for (const LHAPDF::PDF* p : pdfs) delete p;
+  return (nbad == 0) ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+// Stress test of concurrent queries on frozen PDF and AlphaS objects, compared with single-threaded results
+
+#include "LHAPDF/LHAPDF.h"
+#include "LHAPDF/GridPDF.h"
+#include "TestCompare.h"
+#include <iostream>
+#include <cmath>
+#include <thread>
+#include <atomic>
+using namespace std;
+
+// Scan points including the grid edges and extrapolation regions
+void mkPoints(vector<double>& xs, vector<double>& q2s) {
+  for (double log10x = -9.0; log10x <= 0.0; log10x += 0.25) {
+    for (double log10q = -0.5; log10q <= 5.0; log10q += 0.25) {
+      xs.push_back(pow(10, log10x));
+      q2s.push_back(pow(10, 2*log10q));
+    }
+  }
+}
+
+// Query @a pdf from @a nthreads threads at once, each starting at a different point, and count the
+// differences from the single-flavor and alpha_s values in @a ref
+size_t stress(const LHAPDF::PDF& pdf, const vector<double>& xs, const vector<double>& q2s,
+              const vector<double>& ref, const vector<double>& refas, size_t nthreads, size_t nreps) {
+  const vector<int>& pids = pdf.flavors();
+  const size_t npts = xs.size(), npids = pids.size();
+  atomic<size_t> nbad{0};
+  vector<thread> threads;
+  for (size_t t = 0; t < nthreads; ++t) {
+    threads.emplace_back([&, t]() {
+      vector<double> xfs(npids), batch;
+      size_t nbadthread = 0;
+      for (size_t irep = 0; irep < nreps; ++irep) {
+        for (size_t j = 0; j < npts; ++j) {
+          const size_t i = (j + t*npts/nthreads) % npts;
+          for (size_t k = 0; k < npids; ++k)
+            if (!LHAPDF::agree(pdf.xfxQ2(pids[k], xs[i], q2s[i]), ref[i*npids + k])) nbadthread += 1;
+          pdf.xfxQ2(xs[i], q2s[i], pids.data(), xfs.data(), npids);
+          for (size_t k = 0; k < npids; ++k)
+            if (!LHAPDF::agree(xfs[k], ref[i*npids + k])) nbadthread += 1;
+          if (!LHAPDF::agree(pdf.alphasQ2(q2s[i]), refas[i])) nbadthread += 1;
+        }
+        // Batches of points, for one flavor per repetition
+        const size_t k = irep % npids;
+        pdf.xfxQ2(pids[k], xs, q2s, batch);
+        for (size_t i = 0; i < npts; ++i)
+          if (!LHAPDF::agree(batch[i], ref[i*npids + k])) nbadthread += 1;
+      }
+      nbad += nbadthread;
+    });
+  }
+  for (thread& th : threads) th.join();
+  return nbad;
+}
+
+// Make a standalone AlphaS calculator of the given type
+LHAPDF::AlphaS* mkAlphaS(const string& astype) {
+  LHAPDF::AlphaS* as;
+  if (astype == "analytic") {
+    as = new LHAPDF::AlphaS_Analytic();
+    as->setLambda(3, 0.339);
+    as->setLambda(4, 0.296);
+    as->setLambda(5, 0.213);
+  } else {
+    as = new LHAPDF::AlphaS_ODE();
+    as->setMZ(91.1876);
+    as->setAlphaSMZ(0.118);
+  }
+  as->setOrderQCD(4);
+  const double masses[] = {0.0017, 0.0041, 0.1, 1.29, 4.1, 172.5};
+  for (int id = 1; id <= 6; ++id) as->setQuarkMass(id, masses[id-1]);
+  return as;
+}
+
+int main(int argc, char* argv[]) {
+
+  const string setname = (argc > 1) ? argv[1] : "CT10nlo";
+  const size_t nthreads = (argc > 2) ? stoi(argv[2]) : max(4u, thread::hardware_concurrency());
+  const size_t nreps = (argc > 3) ? stoi(argv[3]) : 20;
+  LHAPDF::setVerbosity(0);
+
+  vector<double> xs, q2s;
+  mkPoints(xs, q2s);
+
+  size_t nbad = 0;
+  const vector<string> ipols = {"logcubic", "logcubiccoeffs", "log"};
+  for (const string& ipol : ipols) {
+    // Single-threaded reference values
+    LHAPDF::GridPDF ref(setname, 0);
+    ref.setInterpolator(ipol);
+    const vector<int>& pids = ref.flavors();
+    vector<double> refxfs, refas;
+    for (size_t i = 0; i < xs.size(); ++i) {
+      for (int pid : pids) refxfs.push_back(ref.xfxQ2(pid, xs[i], q2s[i]));
+      refas.push_back(ref.alphasQ2(q2s[i]));
+    }
+
+    // Shared frozen PDF, with its grid data loading deferred to the freeze
+    LHAPDF::getConfig().set_entry("LazyLoad", true);
+    LHAPDF::GridPDF pdf(setname, 0);
+    LHAPDF::getConfig().set_entry("LazyLoad", false);
+    pdf.setInterpolator(ipol);
+    pdf.freeze();
+    const size_t nbadpdf = stress(pdf, xs, q2s, refxfs, refas, nthreads, nreps);
+    cout << ipol << ": " << nbadpdf << " differences from " << nthreads << " threads" << endl;
+    nbad += nbadpdf;
+
+    // Frozen PDFs can't be changed
+    try {
+      pdf.setInterpolator(string("log"));
+      cout << "No error from changing the interpolator of a frozen PDF" << endl;
+      nbad += 1;
+    } catch (const LHAPDF::LogicError&) { }
+  }
+
+  // Standalone analytic and ODE AlphaS calculators, the interpolating one being covered by the PDF
+  const vector<string> astypes = {"analytic", "ode"};
+  for (const string& astype : astypes) {
+    vector<double> refas;
+    LHAPDF::AlphaS* ref = mkAlphaS(astype);
+    for (double q2 : q2s) refas.push_back(ref->alphasQ2(q2));
+    delete ref;
+    LHAPDF::AlphaS* as = mkAlphaS(astype);
+    as->freeze();
+    atomic<size_t> nbadas{0};
+    vector<thread> threads;
+    for (size_t t = 0; t < nthreads; ++t) {
+      threads.emplace_back([&]() {
+        for (size_t irep = 0; irep < nreps; ++irep)
+          for (size_t i = 0; i < q2s.size(); ++i)
+            if (!LHAPDF::agree(as->alphasQ2(q2s[i]), refas[i])) nbadas += 1;
+      });
+    }
+    for (thread& th : threads) th.join();
+    cout << "AlphaS " << astype << ": " << nbadas << " differences from " << nthreads << " threads" << endl;
+    nbad += nbadas;
+    delete as;
+  }
+
+  return (nbad == 0) ? 0 : 1;
+}